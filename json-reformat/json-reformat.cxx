@@ -0,0 +1,250 @@
+// Usage: json-reformat [--indent <num>] [--single] [<file>]
+//
+// Minify (the default), pretty-print (--indent), or normalize (multiple
+// values separated with newlines, for example NDJSON) JSON input text read
+// from the file or, if unspecified or `-`, from stdin and write the result
+// to stdout.
+//
+// --indent <num> -- pretty-print indenting with the specified number of
+//                   spaces
+// --single       -- expect exactly one JSON value rather than a sequence
+//                   of zero or more values
+
+#ifndef _WIN32
+#  include <fcntl.h>    // open()
+#  include <unistd.h>   // close(), write()
+#  include <sys/mman.h> // mmap()
+#  include <sys/stat.h> // fstat()
+#else
+#  include <io.h>       // _write()
+#endif
+
+#include <string>
+#include <cerrno>  // errno, EINTR
+#include <cstdlib> // strtoul()
+#include <cstring> // strcmp()
+#include <fstream>
+#include <iostream>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/reformat.hxx>
+#include <libstud/json/serializer.hxx>
+
+using namespace std;
+using namespace stud::json;
+
+#ifndef _WIN32
+// Memory-mapped input file. Parsing from a buffer is substantially faster
+// than from a stream.
+//
+class mapped_file
+{
+public:
+  explicit
+  mapped_file (const char* path)
+  {
+    fd_ = open (path, O_RDONLY);
+    if (fd_ == -1)
+      return;
+
+    struct stat s;
+    if (fstat (fd_, &s) == 0 && S_ISREG (s.st_mode) && s.st_size != 0)
+    {
+      size_ = static_cast<size_t> (s.st_size);
+
+      void* d (mmap (nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0));
+      if (d != MAP_FAILED)
+      {
+        data_ = d;
+        madvise (data_, size_, MADV_SEQUENTIAL);
+      }
+    }
+  }
+
+  ~mapped_file ()
+  {
+    if (data_ != nullptr)
+      munmap (data_, size_);
+
+    if (fd_ != -1)
+      close (fd_);
+  }
+
+  mapped_file (const mapped_file&) = delete;
+  mapped_file& operator= (const mapped_file&) = delete;
+
+  // Return NULL if the file could not be mapped (an empty or special file,
+  // etc) in which case it should be read as a stream.
+  //
+  const void*
+  data () const {return data_;}
+
+  size_t
+  size () const {return size_;}
+
+private:
+  int fd_ = -1;
+  void* data_ = nullptr;
+  size_t size_ = 0;
+};
+#endif
+
+// Write the text to the stdout file descriptor handling partial writes and
+// interruptions. Return false if writing fails.
+//
+static bool
+write_stdout (const char* d, size_t n)
+{
+  while (n != 0)
+  {
+#ifndef _WIN32
+    ssize_t r (write (1, d, n));
+#else
+    int r (_write (1, d, static_cast<unsigned int> (n)));
+#endif
+    if (r < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      return false;
+    }
+
+    d += r;
+    n -= static_cast<size_t> (r);
+  }
+
+  return true;
+}
+
+// Return false and issue diagnostics if reformatting fails.
+//
+static bool
+reformat (parser& p, buffer_serializer& s, size_t& n)
+{
+  try
+  {
+    n = reformat (p, s);
+    return true;
+  }
+  catch (const invalid_json_input& e)
+  {
+    cerr << e.name << ':' << e.line << ':' << e.column << ": error: "
+         << e.what () << endl;
+  }
+  catch (const invalid_json_output& e)
+  {
+    cerr << "error: " << e.what () << endl;
+  }
+  catch (const ios::failure& e)
+  {
+    cerr << p.input_name << ": error: unable to read: " << e.what () << endl;
+  }
+
+  return false;
+}
+
+int
+main (int argc, const char* argv[])
+{
+  size_t indent (0);
+  bool single (false);
+  const char* path (nullptr);
+
+  for (int i (1); i < argc; i++)
+  {
+    const char* o (argv[i]);
+
+    if (strcmp (o, "--indent") == 0 && i + 1 < argc)
+      indent = strtoul (argv[++i], nullptr, 10);
+    else if (strcmp (o, "--single") == 0)
+      single = true;
+    else if (path == nullptr && (o[0] != '-' || strcmp (o, "-") == 0))
+      path = o;
+    else
+    {
+      cerr << "usage: " << argv[0] << " [--indent <num>] [--single] [<file>]"
+           << endl;
+      return 2;
+    }
+  }
+
+  if (path != nullptr && strcmp (path, "-") == 0)
+    path = nullptr;
+
+  const char* name (path != nullptr ? path : "<stdin>");
+
+  // Write directly to the stdout file descriptor bypassing iostream.
+  //
+  fd_serializer s (1, indent, "\n", 65536);
+
+  bool r;
+  size_t n (0);
+
+#ifndef _WIN32
+  if (path != nullptr)
+  {
+    mapped_file f (path);
+
+    if (f.data () != nullptr)
+    {
+      parser p (f.data (), f.size (), name, !single);
+      r = reformat (p, s, n);
+      goto done;
+    }
+  }
+#endif
+
+  if (path != nullptr)
+  {
+    ifstream is (path, ios::binary);
+
+    if (!is.is_open ())
+    {
+      cerr << path << ": error: unable to open" << endl;
+      return 1;
+    }
+
+    is.exceptions (ios::badbit);
+
+    parser p (is, name, !single);
+    r = reformat (p, s, n);
+  }
+  else
+  {
+    cin.exceptions (ios::badbit);
+
+    parser p (cin, name, !single);
+    r = reformat (p, s, n);
+  }
+
+#ifndef _WIN32
+done:
+#endif
+
+  if (!r)
+    return 1;
+
+  try
+  {
+    s.flush ();
+  }
+  catch (const invalid_json_output& e)
+  {
+    cerr << "error: " << e.what () << endl;
+    return 1;
+  }
+
+  // Terminate the last value with a newline, the same as the rest. Note
+  // that it must be written to the same file descriptor as the output text
+  // (rather than to cout, which is buffered separately).
+  //
+  if (n != 0 && !write_stdout ("\n", 1))
+  {
+    cerr << "error: unable to write JSON output text" << endl;
+    return 1;
+  }
+
+  return 0;
+}
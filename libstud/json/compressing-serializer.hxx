@@ -0,0 +1,168 @@
+#pragma once
+
+#include <ostream>
+#include <cstddef> // size_t
+
+#include <libstud/optional.hxx> // stud::optional is std::optional or similar.
+
+#include <libstud/json/serializer.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Compression mode passed to the compress() function (see below).
+    //
+    enum class compress_mode
+    {
+      none,  // Compress buffering the result as necessary.
+      flush, // Compress and flush the compressed stream.
+      finish // Compress and complete the compressed stream.
+    };
+
+    // Common implementation of the serializers that compress the output text
+    // as it is being serialized and write the result to std::ostream (see
+    // zlib-serializer.hxx and zstd-serializer.hxx for details).
+    //
+    // The derived class (D) should implement the following function that is
+    // called to compress the output text (which may be empty) in the
+    // specified mode and write the result with output():
+    //
+    //   void
+    //   compress (optional<event>, const void*, std::size_t, compress_mode);
+    //
+    // Note that this serializer is header-only and is not used by the
+    // library itself.
+    //
+    template <typename D>
+    class compressing_serializer: public buffer_serializer
+    {
+    public:
+      compressing_serializer (compressing_serializer&&) = delete;
+      compressing_serializer (const compressing_serializer&) = delete;
+
+      compressing_serializer& operator= (compressing_serializer&&) = delete;
+      compressing_serializer& operator= (const compressing_serializer&) = delete;
+
+      // Compress any remaining output text, complete the compressed stream,
+      // and flush the output stream.
+      //
+      void
+      finish ();
+
+    protected:
+      // If sync_flush is true, then after each complete JSON value the
+      // compressed stream is flushed and so is the output stream.
+      //
+      compressing_serializer (std::ostream&,
+                              std::size_t indentation,
+                              const char* multi_value_separator,
+                              bool sync_flush);
+
+      // Write the compressed output text to the output stream.
+      //
+      void
+      output (optional<event>, const char*, std::size_t);
+
+      [[noreturn]] static void
+      fail (optional<event>, const char* description);
+
+      char out_[16384];
+
+    private:
+      static void
+      overflow (void*, event, buffer&, std::size_t);
+
+      static void
+      flush_value (void*, event, buffer&);
+
+      void
+      flush_stream (optional<event>);
+
+      std::ostream& os_;
+      bool sync_;
+      char in_[16384];
+    };
+
+    template <typename D>
+    inline compressing_serializer<D>::
+    compressing_serializer (std::ostream& os,
+                            std::size_t i, const char* mvs,
+                            bool sf)
+        : buffer_serializer (in_, sizeof (in_),
+                             overflow,
+                             flush_value,
+                             this,
+                             i, mvs),
+          os_ (os),
+          sync_ (sf)
+    {
+    }
+
+    template <typename D>
+    inline void compressing_serializer<D>::
+    fail (optional<event> e, const char* d)
+    {
+      throw invalid_json_output (
+        e, invalid_json_output::error_code::buffer_overflow, d);
+    }
+
+    template <typename D>
+    inline void compressing_serializer<D>::
+    output (optional<event> e, const char* d, std::size_t n)
+    {
+      os_.write (d, static_cast<std::streamsize> (n));
+
+      if (os_.fail ())
+        fail (e, "unable to write JSON output text");
+    }
+
+    template <typename D>
+    inline void compressing_serializer<D>::
+    flush_stream (optional<event> e)
+    {
+      os_.flush ();
+
+      if (os_.fail ())
+        fail (e, "unable to write JSON output text");
+    }
+
+    template <typename D>
+    inline void compressing_serializer<D>::
+    overflow (void* d, event e, buffer& b, std::size_t)
+    {
+      D& s (static_cast<D&> (*static_cast<compressing_serializer*> (d)));
+
+      s.compress (e, b.data, b.size, compress_mode::none);
+      b.size = 0;
+    }
+
+    template <typename D>
+    inline void compressing_serializer<D>::
+    flush_value (void* d, event e, buffer& b)
+    {
+      D& s (static_cast<D&> (*static_cast<compressing_serializer*> (d)));
+
+      s.compress (e,
+                  b.data, b.size,
+                  s.sync_ ? compress_mode::flush : compress_mode::none);
+      b.size = 0;
+
+      if (s.sync_)
+        s.flush_stream (e);
+    }
+
+    template <typename D>
+    inline void compressing_serializer<D>::
+    finish ()
+    {
+      static_cast<D*> (this)->compress (nullopt,
+                                        buf_.data, buf_.size,
+                                        compress_mode::finish);
+      buf_.size = 0;
+      unmark ();
+
+      flush_stream (nullopt);
+    }
+  }
+}
@@ -0,0 +1,308 @@
+#include <libstud/json/hasher.hxx>
+
+#include <cstring> // memcpy()
+#include <utility> // pair
+
+using namespace std;
+
+namespace stud
+{
+  namespace json
+  {
+    // MurmurHash3 (x64, 128-bit) by Austin Appleby (public domain).
+    //
+    static const uint64_t c1 (0x87c37b91114253d5ULL);
+    static const uint64_t c2 (0x4cf5ad432745937fULL);
+
+    static inline uint64_t
+    rotl (uint64_t x, int r)
+    {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    static inline uint64_t
+    fmix (uint64_t k)
+    {
+      k ^= k >> 33;
+      k *= 0xff51afd7ed558ccdULL;
+      k ^= k >> 33;
+      k *= 0xc4ceb9fe1a85ec53ULL;
+      k ^= k >> 33;
+      return k;
+    }
+
+    // Load 8 bytes in the little-endian order (so that the hash is the same
+    // regardless of the platform endianness).
+    //
+    static inline uint64_t
+    load (const unsigned char* p, size_t n = 8)
+    {
+      uint64_t r (0);
+      for (size_t i (0); i != n; ++i)
+        r |= static_cast<uint64_t> (p[i]) << (i * 8);
+      return r;
+    }
+
+    static inline void
+    block (uint64_t& h1, uint64_t& h2, const unsigned char* p)
+    {
+      uint64_t k1 (load (p));
+      uint64_t k2 (load (p + 8));
+
+      k1 *= c1; k1 = rotl (k1, 31); k1 *= c2; h1 ^= k1;
+      h1 = rotl (h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+      k2 *= c2; k2 = rotl (k2, 33); k2 *= c1; h2 ^= k2;
+      h2 = rotl (h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    void hasher::state::
+    init (uint64_t seed)
+    {
+      h1 = h2 = seed;
+      size = 0;
+      tail_size = 0;
+    }
+
+    void hasher::state::
+    update (const void* d, size_t n)
+    {
+      const unsigned char* p (static_cast<const unsigned char*> (d));
+
+      size += n;
+
+      // Complete the partial block, if any.
+      //
+      if (tail_size != 0)
+      {
+        size_t m (16 - tail_size);
+
+        if (n < m)
+        {
+          memcpy (tail + tail_size, p, n);
+          tail_size += n;
+          return;
+        }
+
+        memcpy (tail + tail_size, p, m);
+        block (h1, h2, tail);
+        tail_size = 0;
+        p += m;
+        n -= m;
+      }
+
+      for (; n >= 16; p += 16, n -= 16)
+        block (h1, h2, p);
+
+      if (n != 0)
+      {
+        memcpy (tail, p, n);
+        tail_size = n;
+      }
+    }
+
+    void hasher::state::
+    update (uint64_t v)
+    {
+      unsigned char b[8];
+      for (size_t i (0); i != 8; ++i)
+        b[i] = static_cast<unsigned char> (v >> (i * 8));
+
+      update (b, 8);
+    }
+
+    hasher::digest hasher::state::
+    finish () const
+    {
+      uint64_t r1 (h1), r2 (h2);
+
+      if (tail_size != 0)
+      {
+        uint64_t k1 (load (tail, tail_size < 8 ? tail_size : 8));
+        k1 *= c1; k1 = rotl (k1, 31); k1 *= c2; r1 ^= k1;
+
+        if (tail_size > 8)
+        {
+          uint64_t k2 (load (tail + 8, tail_size - 8));
+          k2 *= c2; k2 = rotl (k2, 33); k2 *= c1; r2 ^= k2;
+        }
+      }
+
+      r1 ^= size;
+      r2 ^= size;
+
+      r1 += r2;
+      r2 += r1;
+
+      r1 = fmix (r1);
+      r2 = fmix (r2);
+
+      r1 += r2;
+      r2 += r1;
+
+      return digest {r1, r2};
+    }
+
+    hasher::
+    hasher (bool u, uint64_t s)
+        : unordered_ (u), seed_ (s)
+    {
+      states_.resize (1);
+      states_.back ().init (seed_);
+    }
+
+    void hasher::
+    reset ()
+    {
+      depth_ = 0;
+      states_.resize (1);
+      states_.back ().init (seed_);
+      objects_.clear ();
+    }
+
+    // Canonical encoding tags.
+    //
+    static const unsigned char tag_begin_object = '{';
+    static const unsigned char tag_end_object   = '}';
+    static const unsigned char tag_begin_array  = '[';
+    static const unsigned char tag_end_array    = ']';
+    static const unsigned char tag_name         = 'k';
+    static const unsigned char tag_string       = 's';
+    static const unsigned char tag_number       = 'd';
+    static const unsigned char tag_true         = 't';
+    static const unsigned char tag_false        = 'f';
+    static const unsigned char tag_null         = 'n';
+
+    bool hasher::
+    next (parser& p, event e)
+    {
+      // Hash the tag followed by the length-prefixed data.
+      //
+      auto data = [&p] (state& s, unsigned char t)
+      {
+        pair<const char*, size_t> d (p.data ());
+        s.update (&t, 1);
+        s.update (static_cast<uint64_t> (d.second));
+        s.update (d.first, d.second);
+      };
+
+      // Finish hashing the current object member adding it to the object's
+      // hash.
+      //
+      auto finish_member = [this] ()
+      {
+        object& o (objects_.back ());
+
+        if (o.count != 0)
+        {
+          digest d (states_.back ().finish ());
+          states_.pop_back ();
+
+          o.low += d.low;
+          o.high += d.high;
+        }
+      };
+
+      switch (e)
+      {
+      case event::begin_object:
+        {
+          depth_++;
+
+          if (unordered_)
+          {
+            objects_.push_back (object {0, 0, 0});
+            return false;
+          }
+
+          states_.back ().update (&tag_begin_object, 1);
+          return false;
+        }
+      case event::end_object:
+        {
+          if (unordered_)
+          {
+            finish_member ();
+
+            object o (objects_.back ());
+            objects_.pop_back ();
+
+            state& s (states_.back ());
+            s.update (&tag_begin_object, 1);
+            s.update (o.count);
+            s.update (o.low);
+            s.update (o.high);
+          }
+
+          states_.back ().update (&tag_end_object, 1);
+          break;
+        }
+      case event::name:
+        {
+          if (unordered_)
+          {
+            finish_member ();
+
+            states_.push_back (state ());
+            states_.back ().init (seed_);
+
+            objects_.back ().count++;
+          }
+
+          data (states_.back (), tag_name);
+          return false;
+        }
+      case event::begin_array:
+        {
+          depth_++;
+          states_.back ().update (&tag_begin_array, 1);
+          return false;
+        }
+      case event::end_array:
+        {
+          states_.back ().update (&tag_end_array, 1);
+          break;
+        }
+      case event::string:
+        {
+          data (states_.back (), tag_string);
+          break;
+        }
+      case event::number:
+        {
+          data (states_.back (), tag_number);
+          break;
+        }
+      case event::boolean:
+        {
+          states_.back ().update (p.value<bool> () ? &tag_true : &tag_false, 1);
+          break;
+        }
+      case event::null:
+        {
+          states_.back ().update (&tag_null, 1);
+          break;
+        }
+      }
+
+      if (e == event::end_object || e == event::end_array)
+        depth_--;
+
+      if (depth_ != 0)
+        return false;
+
+      result_ = states_.back ().finish ();
+      states_.back ().init (seed_);
+      return true;
+    }
+
+    const hasher::digest& hasher::
+    hash (parser& p, event e)
+    {
+      while (!next (p, e))
+        e = *p.next ();
+
+      return result_;
+    }
+  }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <vector>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+
+#include <libstud/json/event.hxx>
+#include <libstud/json/parser.hxx>
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Streaming content hash of JSON values.
+    //
+    // The hash is calculated over a canonical encoding of the parser events
+    // and so is independent of the whitespace and escape sequences used in
+    // the input text. Numbers are hashed in their JSON representation (so,
+    // for example, 1 and 1.0 hash differently). The hash function is
+    // MurmurHash3 (x64, 128-bit) and the result is the same on all
+    // platforms. If a 64-bit hash is sufficient, use the low half.
+    //
+    // If ignore_member_order is true, then object members are hashed
+    // individually and combined in a way that does not depend on their
+    // order.
+    //
+    // For example:
+    //
+    //   parser p (cin, "<stdin>", true /* multi_value */);
+    //   hasher h;
+    //   while (p.peek ())
+    //   {
+    //     while (optional<event> e = p.next ())
+    //     {
+    //       if (h.next (p, *e))
+    //       {
+    //         const hasher::digest& d (h.result ());
+    //         ...
+    //       }
+    //     }
+    //   }
+    //
+    class LIBSTUD_JSON_SYMEXPORT hasher
+    {
+    public:
+      struct digest
+      {
+        std::uint64_t low;
+        std::uint64_t high;
+      };
+
+      explicit
+      hasher (bool ignore_member_order = false, std::uint64_t seed = 0);
+
+      // Hash the event that has just been returned by the parser's next()
+      // function. This function should be called for every event, in order,
+      // and before calling peek(). Return true if this event completes a
+      // top-level value, in which case its hash can be obtained with
+      // result().
+      //
+      bool
+      next (parser&, event);
+
+      // Return the hash of the most recently completed top-level value.
+      //
+      const digest&
+      result () const {return result_;}
+
+      // Hash the top-level JSON value whose first event has just been
+      // returned by the parser's next() function (similar to copy_value()).
+      //
+      const digest&
+      hash (parser&, event first);
+
+      // Discard the partially hashed value, if any.
+      //
+      void
+      reset ();
+
+    private:
+      // Incremental MurmurHash3 state.
+      //
+      struct state
+      {
+        std::uint64_t h1, h2;
+        std::uint64_t size;        // Total number of bytes hashed.
+        unsigned char tail[16];
+        std::size_t tail_size;
+
+        void
+        init (std::uint64_t seed);
+
+        void
+        update (const void*, std::size_t);
+
+        void
+        update (std::uint64_t);
+
+        digest
+        finish () const;
+      };
+
+      // Object whose members are being hashed individually (in the
+      // ignore_member_order mode).
+      //
+      struct object
+      {
+        std::uint64_t low, high; // Sum of member hashes.
+        std::uint64_t count;     // Number of members so far.
+      };
+
+      bool unordered_;
+      std::uint64_t seed_;
+      std::size_t depth_ = 0;
+
+      digest result_ {0, 0};
+
+      std::vector<state> states_;   // Current state is last.
+      std::vector<object> objects_; // Current object is last.
+    };
+
+    inline bool
+    operator== (const hasher::digest& x, const hasher::digest& y)
+    {
+      return x.low == y.low && x.high == y.high;
+    }
+
+    inline bool
+    operator!= (const hasher::digest& x, const hasher::digest& y)
+    {
+      return !(x == y);
+    }
+  }
+}
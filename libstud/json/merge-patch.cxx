@@ -0,0 +1,367 @@
+#include <libstud/json/merge-patch.hxx>
+
+#include <cstring>   // memcmp()
+#include <utility>   // move(), pair
+#include <algorithm> // sort(), lower_bound()
+
+#include <libstud/json/reformat.hxx>
+
+using namespace std;
+
+namespace stud
+{
+  namespace json
+  {
+    merge_patch::
+    merge_patch (parser& p)
+    {
+      init (p);
+    }
+
+    merge_patch::
+    merge_patch (const string& t, const char* n)
+    {
+      parser p (t, n);
+      init (p);
+    }
+
+    void merge_patch::
+    init (parser& p)
+    {
+      optional<event> e (p.next ());
+
+      if (!e)
+        throw invalid_json_input (p.input_name != nullptr ? p.input_name : "",
+                                  p.line (),
+                                  p.column (),
+                                  p.position (),
+                                  "expected JSON value instead of end of text");
+
+      parse (p, *e, string ());
+    }
+
+    // Return true if the decoded string contains characters that must be
+    // escaped when serialized (see copy_value() for details).
+    //
+    static inline bool
+    escape (const pair<const char*, size_t>& v)
+    {
+      for (const char* p (v.first), *e (v.first + v.second); p != e; ++p)
+      {
+        const unsigned char c (static_cast<unsigned char> (*p));
+
+        if (c == '"' || c == '\\' || c <= 0x1F)
+          return true;
+      }
+
+      return false;
+    }
+
+    size_t merge_patch::
+    parse (parser& p, event e, string n)
+    {
+      // Note: nodes_ may be reallocated during recursive parsing so we refer
+      // to the node by index.
+      //
+      size_t i (nodes_.size ());
+      nodes_.push_back (node {move (n), kind::value, 0, 0, {}, {}});
+
+      if (e == event::begin_object)
+      {
+        nodes_[i].k = kind::object;
+
+        while (p.next_expect (event::name, event::end_object))
+        {
+          string cn (p.name ());
+          e = *p.next ();
+
+          size_t c;
+          if (e == event::null)
+          {
+            c = nodes_.size ();
+            nodes_.push_back (node {move (cn), kind::remove, 0, 0, {}, {}});
+          }
+          else
+            c = parse (p, e, move (cn));
+
+          nodes_[i].children.push_back (c);
+        }
+
+        // Sort the children by name for lookup while applying the patch and
+        // reject duplicates (which of them should be applied is unclear).
+        //
+        node& n (nodes_[i]);
+
+        n.sorted.resize (n.children.size ());
+        for (size_t j (0); j != n.sorted.size (); ++j)
+          n.sorted[j] = j;
+
+        auto name = [this, &n] (size_t j) -> const string&
+        {
+          return nodes_[n.children[j]].name;
+        };
+
+        sort (n.sorted.begin (), n.sorted.end (),
+              [&name] (size_t x, size_t y) {return name (x) < name (y);});
+
+        for (size_t j (1); j < n.sorted.size (); ++j)
+        {
+          if (name (n.sorted[j]) == name (n.sorted[j - 1]))
+            throw invalid_json_input (
+              p.input_name != nullptr ? p.input_name : "",
+              p.line (),
+              p.column (),
+              p.position (),
+              "duplicate patch object member '" + name (n.sorted[j]) + '\'');
+        }
+      }
+      else
+      {
+        // Save the value's events so that it can be serialized without
+        // parsing it again.
+        //
+        nodes_[i].begin = tokens_.size ();
+
+        for (size_t d (0);; e = *p.next ())
+        {
+          token t {e, data_.size (), 0, false};
+
+          switch (e)
+          {
+          case event::begin_object:
+          case event::begin_array:  d++; break;
+          case event::end_object:
+          case event::end_array:    d--; break;
+          case event::name:
+          case event::string:
+          case event::number:
+          case event::boolean:
+          case event::null:
+            {
+              const pair<const char*, size_t> v (p.data ());
+              data_.append (v.first, v.second);
+              t.size = v.second;
+              t.check = ((e == event::name || e == event::string) &&
+                         escape (v));
+              break;
+            }
+          }
+
+          tokens_.push_back (t);
+
+          if (d == 0)
+            break;
+        }
+
+        nodes_[i].end = tokens_.size ();
+      }
+
+      return i;
+    }
+
+    // Compare the member name with the raw name data.
+    //
+    static int
+    compare (const string& n, const char* s, size_t z)
+    {
+      int r (memcmp (n.c_str (), s, n.size () < z ? n.size () : z));
+      return r != 0 ? r : n.size () < z ? -1 : n.size () > z ? 1 : 0;
+    }
+
+    size_t merge_patch::
+    find (const node& n, const char* s, size_t z) const
+    {
+      auto i (lower_bound (n.sorted.begin (), n.sorted.end (),
+                           make_pair (s, z),
+                           [this, &n] (size_t j,
+                                       const pair<const char*, size_t>& d)
+                           {
+                             return compare (nodes_[n.children[j]].name,
+                                             d.first,
+                                             d.second) < 0;
+                           }));
+
+      return (i != n.sorted.end () &&
+              compare (nodes_[n.children[*i]].name, s, z) == 0
+              ? *i
+              : string::npos);
+    }
+
+    // Skip the JSON value whose first event has just been returned by the
+    // parser's next() function.
+    //
+    static void
+    skip_value (parser& p, event e)
+    {
+      if (e != event::begin_object && e != event::begin_array)
+        return;
+
+      for (size_t d (0);; )
+      {
+        e = *p.next ();
+
+        if (e == event::begin_object || e == event::begin_array)
+          d++;
+        else if (e == event::end_object || e == event::end_array)
+        {
+          if (d == 0)
+            break;
+
+          d--;
+        }
+      }
+    }
+
+    void merge_patch::
+    serialize (buffer_serializer& s, const node& n) const
+    {
+      switch (n.k)
+      {
+      case kind::object:
+        {
+          s.begin_object ();
+
+          for (size_t i: n.children)
+          {
+            const node& c (nodes_[i]);
+
+            if (c.k == kind::remove)
+              continue;
+
+            s.member_name (c.name);
+            serialize (s, c);
+          }
+
+          s.end_object ();
+          break;
+        }
+      case kind::value:
+        {
+          // Serialize the value event by event rather than as JSON text so
+          // that it is indented consistently with the rest of the output.
+          //
+          for (size_t i (n.begin); i != n.end; ++i)
+          {
+            const token& t (tokens_[i]);
+
+            switch (t.type)
+            {
+            case event::begin_object:
+            case event::end_object:
+            case event::begin_array:
+            case event::end_array:
+              s.next (t.type);
+              break;
+            default:
+              s.next (t.type,
+                      make_pair (data_.data () + t.offset, t.size),
+                      t.check);
+              break;
+            }
+          }
+          break;
+        }
+      case kind::remove:
+        break;
+      }
+    }
+
+    void merge_patch::
+    apply (parser& p, buffer_serializer& s, event e) const
+    {
+      vector<bool> done (nodes_.size ());
+      apply (p, s, e, nodes_[0], done);
+    }
+
+    size_t merge_patch::
+    apply (parser& p, buffer_serializer& s) const
+    {
+      size_t r (0);
+
+      // Note that the scratch storage is shared by all the values.
+      //
+      vector<bool> done (nodes_.size ());
+
+      while (p.peek ())
+      {
+        while (optional<event> e = p.next ())
+        {
+          apply (p, s, *e, nodes_[0], done);
+          r++;
+        }
+      }
+
+      return r;
+    }
+
+    void merge_patch::
+    apply (parser& p,
+           buffer_serializer& s,
+           event e,
+           const node& n,
+           vector<bool>& done) const
+    {
+      // A non-object patch replaces the target entirely as does an object
+      // patch a non-object target.
+      //
+      if (n.k != kind::object || e != event::begin_object)
+      {
+        skip_value (p, e);
+        serialize (s, n);
+        return;
+      }
+
+      s.next (e);
+
+      // Patch members that have been applied to the target. Note that a
+      // node can only be applied once at a time (it cannot be nested in
+      // itself) so each member's flag can be indexed by its node position.
+      //
+      for (size_t c: n.children)
+        done[c] = false;
+
+      while ((e = *p.next ()) != event::end_object)
+      {
+        // Note: name's data is only valid until the next event.
+        //
+        const pair<const char*, size_t> d (p.data ());
+        const size_t i (find (n, d.first, d.second));
+
+        if (i == string::npos)
+        {
+          copy_value (p, s, e); // Name.
+          copy_value (p, s, *p.next ());
+          continue;
+        }
+
+        done[n.children[i]] = true;
+
+        const node& c (nodes_[n.children[i]]);
+
+        if (c.k == kind::remove)
+        {
+          p.next_expect_value_skip ();
+          continue;
+        }
+
+        copy_value (p, s, e); // Name.
+        apply (p, s, *p.next (), c, done);
+      }
+
+      // Add the members that are not present in the target.
+      //
+      for (size_t i: n.children)
+      {
+        const node& c (nodes_[i]);
+
+        if (done[i] || c.k == kind::remove)
+          continue;
+
+        s.member_name (c.name);
+        serialize (s, c);
+      }
+
+      s.next (e);
+    }
+  }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef> // size_t
+
+#include <libstud/json/event.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/serializer.hxx>
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Streaming application of a JSON Merge Patch (RFC 7386).
+    //
+    // The patch is parsed in its entirety (duplicate object member names in
+    // the patch are rejected) while the target value is streamed from the
+    // parser to the serializer. Target members that are
+    // not mentioned in the patch are copied with copy_value() (see
+    // reformat.hxx), members that are set to null in the patch are skipped,
+    // and members that are replaced are serialized in place, with new
+    // members appended at the end of the object. As a result, the memory
+    // used is proportional to the patch rather than the target.
+    //
+    // For example:
+    //
+    //   const merge_patch mp ("{\"title\":\"Hello!\",\"author\":null}");
+    //
+    //   parser p (cin, "<stdin>", true /* multi_value */);
+    //   stream_serializer s (cout, 0);
+    //   mp.apply (p, s);
+    //
+    class LIBSTUD_JSON_SYMEXPORT merge_patch
+    {
+    public:
+      // Parse the patch from the JSON value that is next in the parser.
+      //
+      explicit
+      merge_patch (parser&);
+
+      explicit
+      merge_patch (const std::string& text, const char* name = "<patch>");
+
+      // Apply the patch to the JSON value whose first event has just been
+      // returned by the parser's next() function (similar to copy_value()).
+      //
+      void
+      apply (parser&, buffer_serializer&, event first) const;
+
+      // Apply the patch to all the JSON values returning the number of
+      // values patched (similar to reformat()).
+      //
+      std::size_t
+      apply (parser&, buffer_serializer&) const;
+
+    private:
+      enum class kind {object, value, remove};
+
+      // Patch tree node. The root node corresponds to the entire patch.
+      //
+      struct node
+      {
+        std::string name;
+        kind k;
+        std::size_t begin, end; // Tokens of a non-object value.
+        std::vector<std::size_t> children; // In the patch order.
+        std::vector<std::size_t> sorted;   // Children positions by name.
+      };
+
+      // Parsed event of a non-object patch value with its data (name or
+      // value, if any) stored in data_. The check flag indicates whether
+      // the serializer needs to escape the data.
+      //
+      struct token
+      {
+        event type;
+        std::size_t offset;
+        std::size_t size;
+        bool check;
+      };
+
+      void
+      init (parser&);
+
+      std::size_t
+      parse (parser&, event, std::string name);
+
+      // Return the position of the child with the specified name among the
+      // node's children or npos if there is no such child.
+      //
+      std::size_t
+      find (const node&, const char* name, std::size_t size) const;
+
+      // Serialize the result of applying the node to an absent value.
+      //
+      void
+      serialize (buffer_serializer&, const node&) const;
+
+      // The done argument is the scratch storage for marking the patch
+      // object members that have been applied. It is indexed by the node
+      // position and must have an element for each node.
+      //
+      void
+      apply (parser&,
+             buffer_serializer&,
+             event first,
+             const node&,
+             std::vector<bool>& done) const;
+
+      std::vector<node> nodes_;
+      std::vector<token> tokens_;
+      std::string data_;
+    };
+  }
+}
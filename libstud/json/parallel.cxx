@@ -0,0 +1,347 @@
+#include <libstud/json/parallel.hxx>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>   // uint64_t
+#include <cstring>   // memchr()
+#include <exception> // exception_ptr
+
+namespace stud
+{
+  namespace json
+  {
+    using namespace std;
+
+    using element_function = function<void (parser&,
+                                            size_t,
+                                            const array_range&)>;
+
+    // Range of array elements parsed by a single thread.
+    //
+    struct element_range
+    {
+      size_t begin; // Text offset of the first byte.
+      size_t end;   // Text offset past the last byte.
+      size_t index; // Index of the first element.
+      size_t count; // Number of elements.
+
+      array_range origin; // Location of the first byte.
+
+      exception_ptr error;
+    };
+
+    static inline bool
+    json_space (char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // Pre-scan the text splitting the array elements into the specified
+    // number of ranges (or fewer) at the top-level commas that follow the
+    // equally-spaced split points. Return false if the text is not an array
+    // or is structurally invalid, in which case the caller diagnoses the
+    // error by parsing it.
+    //
+    // Note that we only track the string boundaries, the nesting depth, and
+    // the line boundaries here, leaving everything else to the range
+    // parsers.
+    //
+    static bool
+    prescan (const char* s, size_t n, size_t parts, vector<element_range>& rs)
+    {
+      uint64_t line (1); // Current line.
+      size_t lb (0);     // Current line beginning.
+
+      // Column of the cb offset. Calculated incrementally from the previous
+      // range beginning (or the line beginning) since columns are counted
+      // in UTF-8 code points.
+      //
+      size_t cb (0);
+      uint64_t col (1);
+
+      auto origin = [s, &line, &lb, &cb, &col] (size_t b)
+      {
+        if (lb > cb)
+        {
+          cb = lb;
+          col = 1;
+        }
+
+        for (; cb != b; ++cb)
+        {
+          if ((static_cast<unsigned char> (s[cb]) & 0xC0) != 0x80)
+            ++col;
+        }
+
+        return array_range {line, col, b};
+      };
+
+      size_t i (0);
+      for (; i != n && json_space (s[i]); ++i)
+      {
+        if (s[i] == '\n')
+        {
+          ++line;
+          lb = i + 1;
+        }
+      }
+
+      if (i == n || s[i] != '[')
+        return false;
+
+      size_t b (++i);  // Current range beginning.
+      size_t bi (0);   // Current range first element index.
+      size_t cs (0);   // Number of top-level commas.
+      size_t d (1);    // Nesting depth.
+
+      array_range bo (origin (b)); // Current range origin.
+
+      size_t split (b + (n - b) / parts);
+
+      for (; i != n; ++i)
+      {
+        switch (s[i])
+        {
+        case '\n':
+          {
+            ++line;
+            lb = i + 1;
+            break;
+          }
+        case '"':
+          {
+            // Find the closing quote, that is, the first one not preceded
+            // by an odd number of backslashes (we are bound to stop at the
+            // opening quote when counting them).
+            //
+            for (++i;; ++i)
+            {
+              const char* q (
+                static_cast<const char*> (memchr (s + i, '"', n - i)));
+
+              if (q == nullptr)
+                return false;
+
+              i = q - s;
+
+              size_t k (i);
+              for (; s[k - 1] == '\\'; --k) ;
+
+              if ((i - k) % 2 == 0)
+                break;
+            }
+            break;
+          }
+        case '[':
+        case '{':
+          {
+            ++d;
+            break;
+          }
+        case '}':
+        case ']':
+          {
+            if (--d != 0)
+              break;
+
+            if (s[i] != ']')
+              return false;
+
+            // Skip trailing whitespaces.
+            //
+            size_t e (i);
+            for (++i; i != n && json_space (s[i]); ++i) ;
+
+            if (i != n)
+              return false;
+
+            // An empty array has no elements rather than one empty element.
+            //
+            size_t c (cs + 1 - bi);
+            if (cs == 0)
+            {
+              size_t j (b);
+              for (; j != e && json_space (s[j]); ++j) ;
+
+              if (j == e)
+                c = 0;
+            }
+
+            rs.push_back (element_range {b, e, bi, c, bo, nullptr});
+            return true;
+          }
+        case ',':
+          {
+            if (d != 1)
+              break;
+
+            ++cs;
+
+            if (i >= split)
+            {
+              rs.push_back (element_range {b, i, bi, cs - bi, bo, nullptr});
+
+              b = i + 1;
+              bo = origin (b);
+              bi = cs;
+              split = b + (n - b) / (parts - rs.size ());
+            }
+            break;
+          }
+        }
+      }
+
+      return false; // Unterminated array.
+    }
+
+    // Parse the range calling the function for each element. Stop early if
+    // a range that comes before this one fails.
+    //
+    static void
+    parse_range (const char* s,
+                 const char* name,
+                 element_range& r,
+                 size_t ri,
+                 atomic<size_t>& failed,
+                 const element_function& f)
+    {
+      try
+      {
+        // Parse the elements as a comma-separated multi-value sequence. The
+        // pre-scan guarantees that there are no top-level commas inside the
+        // elements, so the number of values parsed must match the number of
+        // elements (for example, in case of an empty element).
+        //
+        parser p (s + r.begin, r.end - r.begin, name, true, ",");
+
+        size_t i (0);
+        for (; p.peek (); ++i)
+        {
+          if (failed.load (memory_order_relaxed) < ri)
+            return;
+
+          f (p, r.index + i, r.origin);
+
+          // Skip the events not consumed by the function, including the
+          // absent event that ends the element, unless the function has
+          // already consumed it.
+          //
+          if (p.value_pending ())
+          {
+            while (p.next ()) ;
+          }
+        }
+
+        if (i != r.count)
+          throw invalid_json_input (name != nullptr ? name : "",
+                                    p.line (),
+                                    p.column (),
+                                    p.position (),
+                                    "expected JSON value");
+      }
+      catch (...)
+      {
+        r.error = current_exception ();
+
+        for (size_t v (failed.load ());
+             v > ri && !failed.compare_exchange_weak (v, ri); ) ;
+      }
+    }
+
+    void
+    parse_array_parallel (const void* t,
+                          size_t n,
+                          const char* name,
+                          const element_function& f,
+                          size_t threads)
+    {
+      const char* s (static_cast<const char*> (t));
+
+      if (threads == 0)
+        threads = thread::hardware_concurrency ();
+
+      // Splitting small inputs is not worth it.
+      //
+      const size_t min_range (1024 * 1024);
+
+      if (threads > n / min_range)
+        threads = n / min_range;
+
+      if (threads == 0)
+        threads = 1;
+
+      vector<element_range> rs;
+      rs.reserve (threads);
+
+      if (!prescan (s, n, threads, rs))
+      {
+        parser p (s, n, name);
+        p.next_expect (event::begin_array);
+        while (p.next ()) ;
+
+        // Should not be reached.
+        //
+        throw invalid_json_input (name != nullptr ? name : "",
+                                  p.line (),
+                                  p.column (),
+                                  p.position (),
+                                  "invalid JSON array");
+      }
+
+      // Parse the first range on this thread.
+      //
+      atomic<size_t> failed (rs.size ());
+      {
+        vector<thread> ts;
+        ts.reserve (rs.size () - 1);
+
+        try
+        {
+          for (size_t i (1); i != rs.size (); ++i)
+            ts.emplace_back (parse_range,
+                             s, name, ref (rs[i]), i, ref (failed), cref (f));
+        }
+        catch (...)
+        {
+          failed = 0;
+
+          for (thread& th: ts)
+            th.join ();
+
+          throw;
+        }
+
+        parse_range (s, name, rs[0], 0, failed, f);
+
+        for (thread& th: ts)
+          th.join ();
+      }
+
+      // Rethrow the first error adjusting the location of input errors.
+      //
+      for (const element_range& r: rs)
+      {
+        if (!r.error)
+          continue;
+
+        try
+        {
+          rethrow_exception (r.error);
+        }
+        catch (invalid_json_input& e)
+        {
+          const array_range& o (r.origin);
+
+          if (e.line == 1)
+            e.column += o.column - 1;
+
+          e.line += o.line - 1;
+          e.position += o.position;
+
+          throw;
+        }
+      }
+    }
+  }
+}
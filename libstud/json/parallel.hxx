@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>    // size_t
+#include <cstdint>    // uint64_t
+#include <functional>
+
+#include <libstud/optional.hxx> // stud::optional is std::optional or similar.
+
+#include <libstud/json/event.hxx>
+#include <libstud/json/parser.hxx>
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Location of the beginning of a range of array elements parsed by a
+    // single parser (see parse_array_parallel() below for details).
+    //
+    // The parser's line(), column(), and position() are relative to the
+    // beginning of its range. The input_*() functions translate them to be
+    // relative to the entire input text.
+    //
+    struct array_range
+    {
+      std::uint64_t line;     // Line of the range's first byte (1-based).
+      std::uint64_t column;   // Column of the range's first byte (1-based).
+      std::uint64_t position; // Position of the range's first byte.
+
+      std::uint64_t
+      input_line (const parser& p) const
+      {
+        return line + p.line () - 1;
+      }
+
+      std::uint64_t
+      input_column (const parser& p) const
+      {
+        return p.line () == 1 ? column + p.column () - 1 : p.column ();
+      }
+
+      std::uint64_t
+      input_position (const parser& p) const
+      {
+        return position + p.position ();
+      }
+    };
+
+    // Parse the elements of a top-level JSON array in parallel.
+    //
+    // The JSON input text buffer (for example, a memory-mapped file) must
+    // contain a single array. It is first quickly pre-scanned to locate
+    // the top-level element boundaries and is then split into ranges of
+    // elements of roughly equal size, each parsed on a separate thread with
+    // its own parser instance.
+    //
+    // The function is called for each element with the parser positioned
+    // before the element's first event (so the first next() call returns
+    // it), the element's index in the array, and the range being parsed.
+    // Any events of the element that are not consumed by the function are
+    // skipped (the function may, but need not, consume the absent event
+    // that ends the element but should not peek past it). Note that the
+    // parser's location is relative to the range (see array_range above for
+    // details). Note also that the function is called concurrently on
+    // multiple threads (but for elements of the same range, in order, on
+    // the same thread).
+    //
+    // If the threads argument is 0, then the hardware concurrency is used.
+    // Fewer threads may be used for small inputs.
+    //
+    // If the input is invalid, then invalid_json_input is thrown with the
+    // location relative to the entire input text. If errors (or any other
+    // exceptions, including thrown by the function) occur in several
+    // ranges, then the one that comes first in the input is thrown. Note
+    // that the function may have been called for elements that come after
+    // the error.
+    //
+    LIBSTUD_JSON_SYMEXPORT void
+    parse_array_parallel (const void* text,
+                          std::size_t size,
+                          const char* name,
+                          const std::function<void (parser&,
+                                                    std::size_t index,
+                                                    const array_range&)>&,
+                          std::size_t threads = 0);
+  }
+}
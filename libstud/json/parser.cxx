@@ -40,12 +40,126 @@ namespace stud
   {
     using namespace std;
 
+    // The parser on which the underlying parser's allocation functions are
+    // called if the limits are set (see parser::set_limits() for details).
+    //
+    // Note that the underlying parser's allocator interface does not provide
+    // a way to pass any user data to these functions and so we have to use
+    // this thread-local variable instead.
+    //
+    static thread_local parser* current_parser = nullptr;
+
+    // Set the current parser for the duration of the underlying parser's
+    // call.
+    //
+    // Note that every call that may (re)allocate or free memory through the
+    // underlying parser's allocator (json_next(), json_close(), and
+    // alloc.free()) must be made with this guard in place since otherwise
+    // the allocation functions will be called with no or some other parser
+    // as current. The remaining calls (json_reset(), json_get_*(), etc) do
+    // not allocate.
+    //
+    struct current_guard
+    {
+      explicit
+      current_guard (parser* p): prev_ (current_parser) {current_parser = p;}
+      ~current_guard () {current_parser = prev_;}
+
+    private:
+      parser* prev_;
+    };
+
     parser::
     ~parser ()
     {
+      current_guard g (this);
+      impl_->alloc.free (spare_);
       json_close (impl_);
     }
 
+    void parser::
+    set_limits (const limits& l, void* s, size_t n)
+    {
+      // Changing the allocator after the underlying parser has allocated
+      // anything would be asking for trouble.
+      //
+      if (parsed_ || peeked_)
+        throw invalid_argument ("parsing limits set after parsing started");
+
+      if (s != nullptr && n < 1024)
+        throw invalid_argument ("parsing storage size less than 1024 bytes");
+
+      limits_ = l;
+      storage_ = s;
+      storage_size_ = s != nullptr ? n : 0;
+
+      // Note that json_set_allocator() copies the functions.
+      //
+      json_allocator a {&limits_malloc, &limits_realloc, &limits_free};
+      json_set_allocator (impl_, &a);
+    }
+
+    // The underlying parser allocates the string buffer with malloc() and
+    // grows it (as well as allocates and grows the nesting stack) with
+    // realloc().
+    //
+    void* parser::
+    limits_malloc (size_t n)
+    {
+      parser& p (*current_parser);
+
+      if (p.storage_ != nullptr)
+      {
+        if (n <= p.storage_size_)
+          return p.storage_;
+
+        p.limit_error_ = "string length limit exceeded";
+        return nullptr;
+      }
+
+      return malloc (n);
+    }
+
+    void* parser::
+    limits_realloc (void* b, size_t n)
+    {
+      parser& p (*current_parser);
+
+      if (b != nullptr && b == p.impl_->data.string)
+      {
+        if (b == p.storage_)
+        {
+          if (n <= p.storage_size_)
+            return b;
+
+          p.limit_error_ = "string length limit exceeded";
+          return nullptr;
+        }
+
+        // If the current buffer can already hold the longest allowed string
+        // (plus '\0'), then this one is too long. This way we allocate at
+        // most twice the limit (the buffer grows by doubling).
+        //
+        size_t m (p.limits_.max_string);
+        if (m != 0 && p.impl_->data.string_size > m)
+        {
+          p.limit_error_ = "string length limit exceeded";
+          return nullptr;
+        }
+      }
+
+      return realloc (b, n);
+    }
+
+    void parser::
+    limits_free (void* b)
+    {
+      parser& p (*current_parser);
+
+      if (b != p.storage_)
+        free (b);
+    }
+
     static int
     stream_get (void* x)
     {
@@ -63,7 +177,16 @@ namespace stud
           // We first peek not to trip failbit on EOF.
           //
           if (s.is->peek () != istream::traits_type::eof ())
+          {
+#ifndef LIBSTUD_JSON_STATISTICS
             return static_cast<char> (s.is->get ());
+#else
+            const char c (static_cast<char> (s.is->get ()));
+            if (c == '\\')
+              s.backslashes++;
+            return c;
+#endif
+          }
         }
         catch (...)
         {
@@ -110,7 +233,11 @@ namespace stud
     parser::
     parser (istream& is, const char* n, bool mv, const char* sep) noexcept
         : input_name (n),
+#ifndef LIBSTUD_JSON_STATISTICS
           stream_ {&is, nullopt},
+#else
+          stream_ {&is, nullopt, 0},
+#endif
           multi_value_ (mv),
           separators_ (sep),
           raw_s_ (nullptr),
@@ -127,7 +254,11 @@ namespace stud
             bool mv,
             const char* sep) noexcept
         : input_name (n),
+#ifndef LIBSTUD_JSON_STATISTICS
           stream_ {nullptr, nullopt},
+#else
+          stream_ {nullptr, nullopt, 0},
+#endif
           multi_value_ (mv),
           separators_ (sep),
           raw_s_ (nullptr),
@@ -137,6 +268,248 @@ namespace stud
       json_set_streaming (impl_, multi_value_);
     }
 
+    parser::
+    parser (incremental_tag,
+            const char* n,
+            bool mv,
+            const char* sep) noexcept
+        : input_name (n),
+#ifndef LIBSTUD_JSON_STATISTICS
+          stream_ {nullptr, nullopt},
+#else
+          stream_ {nullptr, nullopt, 0},
+#endif
+          incremental_ (true),
+          multi_value_ (mv),
+          separators_ (sep),
+          raw_s_ (nullptr),
+          raw_n_ (0)
+    {
+      json_open_user (impl_, &incremental_get, &incremental_peek, this);
+      json_set_streaming (impl_, multi_value_);
+    }
+
+    int parser::
+    incremental_get (void* x)
+    {
+      parser& p (*static_cast<parser*> (x));
+      incremental_input& in (p.input_);
+
+      if (in.read != in.buffer.size ())
+      {
+        const char c (in.buffer[in.read++]);
+
+#ifdef LIBSTUD_JSON_STATISTICS
+        if (c == '\\')
+          p.stream_.backslashes++;
+#endif
+        return c;
+      }
+
+      if (!in.finished)
+        in.starved = true;
+
+      return EOF;
+    }
+
+    int parser::
+    incremental_peek (void* x)
+    {
+      incremental_input& in (static_cast<parser*> (x)->input_);
+
+      if (in.read != in.buffer.size ())
+        return in.buffer[in.read];
+
+      if (!in.finished)
+        in.starved = true;
+
+      return EOF;
+    }
+
+    void parser::
+    feed (const void* d, size_t n)
+    {
+      incremental_input& in (input_);
+
+      assert (!in.finished);
+
+      // Discard the input text already read if it is at least half of the
+      // buffer (so that we don't keep moving a long incomplete token).
+      //
+      if (in.read != 0 && in.read * 2 >= in.buffer.size ())
+      {
+        // Adjust the scan offsets if the scan is still current (see ready()
+        // for details) and invalidate it otherwise.
+        //
+        if (in.scan_begin == in.read)
+        {
+          in.scan -= in.read;
+
+          if (in.token >= in.read)
+            in.token -= in.read;
+
+          in.scan_begin = 0;
+        }
+        else
+          in.scan_begin = string::npos;
+
+        in.buffer.erase (0, in.read);
+        in.read = 0;
+      }
+
+      in.buffer.append (static_cast<const char*> (d), n);
+    }
+
+    void parser::
+    finish () noexcept
+    {
+      input_.finished = true;
+    }
+
+    static inline bool
+    literal_char (char c)
+    {
+      return (c >= '0' && c <= '9') ||
+             (c >= 'a' && c <= 'z') ||
+             (c >= 'A' && c <= 'Z') ||
+             c == '-' || c == '+' || c == '.';
+    }
+
+    bool parser::
+    ready ()
+    {
+      incremental_input& in (input_);
+
+      // Nothing (more) needs to be read if the next event has already been
+      // peeked or if the end of input has been reached. Also, in the
+      // multi-value mode, the absent event that follows a value is returned
+      // without reading anything (see the JSON_DONE case in next_impl()).
+      //
+      if (peeked_ || in.finished || limit_error_ != nullptr)
+        return true;
+
+      if (multi_value_          &&
+          parsed_               &&
+          *parsed_ != JSON_DONE &&
+          json_get_depth (impl_) == 0)
+        return true;
+
+      // Otherwise, see if the input text contains the complete next token
+      // preceded by any whitespaces, separators, and commas/colons. If the
+      // token is a number or a literal, then the character that follows it
+      // is also required since the underlying parser peeks at it to find
+      // the end of the token. Note that this is conservative: some tokens
+      // (for example, invalid) could be parsed with less input.
+      //
+      // Continue the previous scan if nothing has been read since.
+      //
+      if (in.scan_begin != in.read)
+      {
+        in.scan_begin = in.scan = in.read;
+        in.state = scan_state::skip;
+      }
+
+      if (in.state == scan_state::done)
+        return true;
+
+      const char* b (in.buffer.data ());
+      size_t n (in.buffer.size ());
+      size_t i (in.scan);
+
+      for (; i != n; ++i)
+      {
+        const char c (b[i]);
+
+        switch (in.state)
+        {
+        case scan_state::skip:
+          {
+            if (json_isspace (c) || c == ',' || c == ':' ||
+                (multi_value_           &&
+                 separators_ != nullptr &&
+                 c != '\0'              &&
+                 strchr (separators_, c) != nullptr))
+              continue;
+
+            in.token = i;
+
+            if (c == '"')
+              in.state = scan_state::string;
+            else if (literal_char (c))
+              in.state = scan_state::literal;
+            else
+              break; // Structural (or invalid) character.
+
+            continue;
+          }
+        case scan_state::string:
+          {
+            if (c == '\\')
+              in.state = scan_state::escape;
+            else if (c == '"')
+              break;
+
+            continue;
+          }
+        case scan_state::escape:
+          {
+            in.state = scan_state::string;
+            continue;
+          }
+        case scan_state::literal:
+          {
+            if (literal_char (c))
+              continue;
+
+            break;
+          }
+        case scan_state::done:
+          assert (false);
+        }
+
+        in.state = scan_state::done;
+        break;
+      }
+
+      in.scan = i;
+
+      if (in.state == scan_state::done)
+        return true;
+
+      // If the incomplete token is already known to exceed the limits, then
+      // let next() diagnose it (see next_impl()).
+      //
+      // Note that an escape sequence in a string can be up to 6 characters
+      // long and that the fixed storage includes the terminating '\0'.
+      //
+      if (in.state != scan_state::skip)
+      {
+        size_t m (limits_.max_string);
+
+        if (storage_ != nullptr && (m == 0 || m >= storage_size_))
+          m = storage_size_ - 1;
+
+        if (m != 0 &&
+            n - in.token > (in.state == scan_state::literal ? m : 6 * m + 1))
+        {
+          limit_error_ = "string length limit exceeded";
+          return true;
+        }
+      }
+
+      // All the input text supplied so far will have to be read before the
+      // next event can be parsed.
+      //
+      if (limits_.max_bytes != 0 &&
+          json_get_position (impl_) + (n - in.read) > limits_.max_bytes)
+      {
+        limit_error_ = "input size limit exceeded";
+        return true;
+      }
+
+      return false;
+    }
+
     optional<event> parser::
     next ()
     {
@@ -149,11 +522,13 @@ namespace stud
       {
         parsed_ = peeked_;
         peeked_ = nullopt;
+        raw_s_ = peeked_s_;
+        raw_n_ = peeked_n_;
       }
       else
         parsed_ = next_impl ();
 
-      return translate (*parsed_);
+      return parsed_event_ = translate (*parsed_);
     }
 
     optional<event> parser::
@@ -161,16 +536,176 @@ namespace stud
     {
       if (!peeked_)
       {
+        const char* s (raw_s_);
+        size_t n (raw_n_);
+
         if (parsed_)
         {
-          cache_parsed_data ();
           cache_parsed_location ();
+
+          // Preserve the parsed string or number by giving the underlying
+          // parser the spare buffer for the peeked event (it allocates one
+          // if it is NULL). Note that this is not possible with the fixed
+          // storage (see set_limits()) in which case we fall back to
+          // copying.
+          //
+          if (*parsed_ == JSON_STRING || *parsed_ == JSON_NUMBER)
+          {
+            if (storage_ == nullptr)
+            {
+              swap (impl_->data.string, spare_);
+              swap (impl_->data.string_size, spare_size_);
+            }
+            else
+            {
+              if (!name_p_ && !value_p_)
+              {
+                cache_parsed_data ();
+
+#ifdef LIBSTUD_JSON_STATISTICS
+                stats_.peek_copies++;
+#endif
+              }
+
+              if (name_p_)
+                s = name_.c_str ();
+              else if (value_p_)
+                s = value_.c_str ();
+            }
+          }
         }
+
         peeked_ = next_impl ();
+
+        peeked_s_ = raw_s_;
+        peeked_n_ = raw_n_;
+        raw_s_ = s;
+        raw_n_ = n;
       }
       return translate (*peeked_);
     }
 
+    size_t parser::
+    next_batch (token* ts, size_t n, string& d)
+    {
+      // Note that this is a specialized version of the next() plus
+      // translate() combination.
+      //
+      const size_t db (d.size ()); // Beginning of the copied values.
+
+      size_t i (0);
+      for (; i != n; ++i)
+      {
+        json_type e;
+
+        if (peeked_)
+        {
+          e = *peeked_;
+          peeked_ = nullopt;
+          raw_s_ = peeked_s_;
+          raw_n_ = peeked_n_;
+        }
+        else
+          e = next_impl ();
+
+        parsed_ = e;
+
+        if (e == JSON_DONE)
+          break;
+
+        token& t (ts[i]);
+        t.depth = json_get_depth (impl_);
+
+        switch (e)
+        {
+        case JSON_OBJECT:     t.type = event::begin_object; t.depth--; break;
+        case JSON_ARRAY:      t.type = event::begin_array;  t.depth--; break;
+        case JSON_OBJECT_END: t.type = event::end_object;              break;
+        case JSON_ARRAY_END:  t.type = event::end_array;               break;
+        case JSON_NUMBER:     t.type = event::number;                  break;
+        case JSON_TRUE:
+        case JSON_FALSE:      t.type = event::boolean;                 break;
+        case JSON_NULL:       t.type = event::null;                    break;
+        case JSON_STRING:
+          {
+            size_t c;
+            t.type = json_get_context (impl_, &c) == JSON_OBJECT && c % 2 == 1
+                     ? event::name
+                     : event::string;
+            break;
+          }
+        case JSON_DONE:
+        case JSON_ERROR: assert (false); // Handled above or by next_impl().
+        }
+
+        t.size = raw_n_;
+
+        // Point to the raw value in the input text if it is in memory and
+        // the value is there verbatim (see below), and copy it otherwise.
+        // Note that the copied values are pointed to at the end since the
+        // data string may be reallocated.
+        //
+        switch (e)
+        {
+        case JSON_STRING:
+        case JSON_NUMBER:
+          {
+            t.data = nullptr;
+
+            if (stream_.is == nullptr && !incremental_)
+            {
+              const char* b (impl_->source.source.buffer.buffer);
+              size_t p (json_get_position (impl_));
+
+              // The number ends at the current position (the character
+              // that follows it is only peeked at) while the string ends
+              // before the closing quote. The string is there verbatim if it
+              // contains no backslashes and is preceded by the opening
+              // quote (an escaped quote there would make the decoded value
+              // longer).
+              //
+              if (e == JSON_NUMBER)
+                t.data = b + p - raw_n_;
+              else if (p >= raw_n_ + 2 &&
+                       b[p - raw_n_ - 2] == '"' &&
+                       memchr (b + p - raw_n_ - 1, '\\', raw_n_) == nullptr)
+                t.data = b + p - raw_n_ - 1;
+            }
+
+            if (t.data == nullptr)
+              d.append (raw_s_, raw_n_);
+
+            break;
+          }
+        default:
+          t.data = raw_s_; // Static literal or NULL.
+        }
+      }
+
+      for (size_t j (0), o (db); j != i; ++j)
+      {
+        token& t (ts[j]);
+
+        if (t.data == nullptr &&
+            (t.type == event::name   ||
+             t.type == event::string ||
+             t.type == event::number))
+        {
+          t.data = d.data () + o;
+          o += t.size;
+        }
+      }
+
+      name_p_ = value_p_ = location_p_ = false;
+
+      if (i != n)
+        parsed_event_ = nullopt;
+      else if (i != 0)
+        parsed_event_ = ts[i - 1].type;
+
+      return i;
+    }
+
     static inline const char*
     event_name (event e)
     {
@@ -190,6 +725,230 @@ namespace stud
       return "";
     }
 
+    // 64-bit FNV-1a hash.
+    //
+    static inline uint64_t
+    name_hash (const char* s, size_t n)
+    {
+      uint64_t h (0xcbf29ce484222325ULL);
+      for (const char* e (s + n); s != e; ++s)
+      {
+        h ^= static_cast<unsigned char> (*s);
+        h *= 0x100000001b3ULL;
+      }
+      return h;
+    }
+
+    size_t parser::
+    find_name (const char* s, size_t n, uint64_t h) const
+    {
+      if (name_slots_.empty ())
+        return string::npos;
+
+      const size_t m (name_slots_.size () - 1);
+
+      for (size_t i (h & m);; i = (i + 1) & m)
+      {
+        size_t id (name_slots_[i]);
+
+        if (id == 0)
+          return string::npos;
+
+        const pair<string, uint64_t>& e (names_[id - 1]);
+
+        if (e.second == h && e.first.size () == n &&
+            (n == 0 || memcmp (e.first.data (), s, n) == 0))
+          return id - 1;
+      }
+    }
+
+    size_t parser::
+    intern (const char* s, size_t n)
+    {
+      uint64_t h (name_hash (s, n));
+
+      size_t r (find_name (s, n, h));
+      if (r != string::npos)
+        return r;
+
+      r = names_.size ();
+      names_.emplace_back (string (s, n), h);
+
+      // Rehash if the table would become more than half full.
+      //
+      if (name_slots_.size () < names_.size () * 2)
+      {
+        name_slots_.assign (name_slots_.empty () ? 16 : name_slots_.size () * 2,
+                            0);
+
+        const size_t m (name_slots_.size () - 1);
+        for (size_t id (0); id != names_.size (); ++id)
+        {
+          size_t i (names_[id].second & m);
+          for (; name_slots_[i] != 0; i = (i + 1) & m) ;
+          name_slots_[i] = id + 1;
+        }
+      }
+      else
+      {
+        const size_t m (name_slots_.size () - 1);
+        size_t i (h & m);
+        for (; name_slots_[i] != 0; i = (i + 1) & m) ;
+        name_slots_[i] = r + 1;
+      }
+
+      return r;
+    }
+
+    size_t parser::
+    name_id () const
+    {
+      if (!name_p_)
+      {
+        assert (parsed_ && parsed_event_ == event::name);
+        return find_name (raw_s_, raw_n_, name_hash (raw_s_, raw_n_));
+      }
+
+      return find_name (name_.data (),
+                        name_.size (),
+                        name_hash (name_.data (), name_.size ()));
+    }
+
+    // Base64 alphabet character values with 0xFF for invalid characters.
+    //
+    static const uint8_t base64_values[256] =
+    {
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x00
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x10
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x20
+      0xFF, 0xFF, 0xFF, 62,   0xFF, 0xFF, 0xFF, 63,   //       + /
+      52,   53,   54,   55,   56,   57,   58,   59,   // 0x30  0-7
+      60,   61,   0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, //       8-9
+      0xFF, 0,    1,    2,    3,    4,    5,    6,    // 0x40  A-G
+      7,    8,    9,    10,   11,   12,   13,   14,   //       H-O
+      15,   16,   17,   18,   19,   20,   21,   22,   // 0x50  P-W
+      23,   24,   25,   0xFF, 0xFF, 0xFF, 0xFF, 0xFF, //       X-Z
+      0xFF, 26,   27,   28,   29,   30,   31,   32,   // 0x60  a-g
+      33,   34,   35,   36,   37,   38,   39,   40,   //       h-o
+      41,   42,   43,   44,   45,   46,   47,   48,   // 0x70  p-w
+      49,   50,   51,   0xFF, 0xFF, 0xFF, 0xFF, 0xFF, //       x-z
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x80
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0x90
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xA0
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xB0
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xC0
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xD0
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xE0
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, // 0xF0
+      0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+
+    size_t parser::
+    value_base64 (void* b, size_t c) const
+    {
+      const char* s;
+      size_t n;
+
+      if (!value_p_)
+      {
+        assert (parsed_ && *parsed_ == JSON_STRING);
+        s = raw_s_;
+        n = raw_n_;
+      }
+      else
+      {
+        s = value_.data ();
+        n = value_.size ();
+      }
+
+      const char* d; // Description.
+
+      if (n % 4 != 0)
+      {
+        d = "invalid base64 value: length is not a multiple of 4";
+        goto fail;
+      }
+
+      {
+        // Number of padding characters.
+        //
+        size_t pn (n == 0 ? 0 : s[n - 1] != '=' ? 0 : s[n - 2] != '=' ? 1 : 2);
+
+        size_t r (n / 4 * 3 - pn);
+        if (r > c)
+        {
+          d = "base64 value does not fit into buffer";
+          goto fail;
+        }
+
+        const uint8_t* p (reinterpret_cast<const uint8_t*> (s));
+        uint8_t* o (static_cast<uint8_t*> (b));
+
+        // Decode complete 4-character groups accumulating the invalid
+        // character check (invalid characters have the high bit set).
+        //
+        // Note that there is no separate fast path (unlike in the
+        // serializer, where encoding directly into the output buffer saves
+        // a copy): the value is already decoded from where pdjson keeps it
+        // directly into the caller's buffer, the loop below is branch-free,
+        // and the validity check is deferred until the end. A faster,
+        // vectorized decoder would tie the library to specific instruction
+        // sets, which we avoid.
+        //
+        uint8_t inv (0);
+        for (const uint8_t* e (p + (pn != 0 ? n - 4 : n)); p != e; p += 4)
+        {
+          uint8_t v0 (base64_values[p[0]]), v1 (base64_values[p[1]]),
+                  v2 (base64_values[p[2]]), v3 (base64_values[p[3]]);
+
+          inv |= v0 | v1 | v2 | v3;
+
+          *o++ = static_cast<uint8_t> ((v0 << 2) | (v1 >> 4));
+          *o++ = static_cast<uint8_t> ((v1 << 4) | (v2 >> 2));
+          *o++ = static_cast<uint8_t> ((v2 << 6) | v3);
+        }
+
+        // Decode the padded group, if any.
+        //
+        if (pn != 0)
+        {
+          uint8_t v0 (base64_values[p[0]]),
+                  v1 (base64_values[p[1]]),
+                  v2 (pn == 1 ? base64_values[p[2]] : 0);
+
+          inv |= v0 | v1 | v2;
+
+          *o++ = static_cast<uint8_t> ((v0 << 2) | (v1 >> 4));
+          if (pn == 1)
+            *o++ = static_cast<uint8_t> ((v1 << 4) | (v2 >> 2));
+        }
+
+        if ((inv & 0x80) != 0)
+        {
+          d = "invalid base64 value: invalid character";
+          goto fail;
+        }
+
+        return r;
+      }
+
+    fail:
+      throw invalid_json_input (input_name != nullptr ? input_name : "",
+                                line (),
+                                column (),
+                                position (),
+                                d);
+    }
+
     bool parser::
     next_expect (event p, optional<event> s)
     {
@@ -415,6 +1174,12 @@ namespace stud
         return make_pair (r, c);
       };
 
+      // Report a limit violation detected by ready() for the incremental
+      // input.
+      //
+      if (limit_error_ != nullptr)
+        goto fail_limit;
+
       // In the multi-value mode skip any instances of required separators
       // (and any other JSON whitespace) preceding the first JSON value.
       //
@@ -427,9 +1192,39 @@ namespace stud
         }
       }
 
-      e = json_next (impl_);
+      // For the incremental input, skip the separators following the
+      // previous value (see the JSON_DONE case below for details).
+      //
+      if (input_.separators)
+      {
+        input_.separators = false;
+
+        auto p (skip_separators ());
+
+        if (!p.first && p.second != EOF)
+        {
+          json_source_get (impl_); // Consume to update column number.
+          goto fail_separation;
+        }
+      }
 
-      // First check for a pending input/output error.
+      {
+        current_guard g (this);
+        e = json_next (impl_);
+      }
+
+      // For the incremental input, make sure that ready() was called (and
+      // returned true) before calling next() or peek().
+      //
+      assert (!input_.starved);
+
+      // Then check for a limit violation detected during allocation (which
+      // the underlying parser reports as an out of memory error).
+      //
+      if (limit_error_ != nullptr)
+        goto fail_limit;
+
+      // Next check for a pending input/output error.
       //
       if (stream_.is != nullptr)
       {
@@ -464,10 +1259,22 @@ namespace stud
           // first one in case there are no values) that signals the end of
           // input.
           //
+          // For the incremental input, the separators may not have been
+          // supplied yet and so we postpone skipping them until the next
+          // value (or the end of input) is parsed. This way we don't delay
+          // returning this event until then.
+          //
           if (multi_value_         &&
               (parsed_ || peeked_) &&
               (peeked_ ? *peeked_ : *parsed_) != JSON_DONE)
           {
+            if (incremental_)
+            {
+              input_.separators = true;
+              json_reset (impl_);
+              break;
+            }
+
             auto p (skip_separators ());
 
             if (p.second == EOF && stream_.is != nullptr)
@@ -500,6 +1307,56 @@ namespace stud
       default: break;
       }
 
+      // Check the limits that are not enforced by the allocation functions.
+      //
+      if (limits_.max_bytes != 0 &&
+          json_get_position (impl_) > limits_.max_bytes)
+      {
+        limit_error_ = "input size limit exceeded";
+        goto fail_limit;
+      }
+
+      switch (e)
+      {
+      case JSON_STRING:
+      case JSON_NUMBER:
+        {
+          if (limits_.max_string != 0 && raw_n_ > limits_.max_string)
+          {
+            limit_error_ = "string length limit exceeded";
+            goto fail_limit;
+          }
+
+          size_t n;
+          if (limits_.max_members != 0 &&
+              json_get_context (impl_, &n) == JSON_OBJECT &&
+              n % 2 == 1 &&
+              (n + 1) / 2 > limits_.max_members)
+          {
+            limit_error_ = "object member limit exceeded";
+            goto fail_limit;
+          }
+          break;
+        }
+      case JSON_OBJECT:
+      case JSON_ARRAY:
+        {
+          if (limits_.max_depth != 0 &&
+              json_get_depth (impl_) > limits_.max_depth)
+          {
+            limit_error_ = "nesting depth limit exceeded";
+            goto fail_limit;
+          }
+          break;
+        }
+      default:
+        break;
+      }
+
+#ifdef LIBSTUD_JSON_STATISTICS
+      update_stats (e);
+#endif
+
       return e;
 
     fail_json:
@@ -510,6 +1367,14 @@ namespace stud
           static_cast<uint64_t> (json_get_position (impl_)),
           json_get_error (impl_));
 
+    fail_limit:
+      throw invalid_json_input (
+          input_name != nullptr ? input_name : "",
+          static_cast<uint64_t> (json_get_lineno (impl_)),
+          static_cast<uint64_t> (json_get_column (impl_)),
+          static_cast<uint64_t> (json_get_position (impl_)),
+          limit_error_);
+
     fail_separation:
       throw invalid_json_input (
           input_name != nullptr ? input_name : "",
@@ -534,6 +1399,72 @@ namespace stud
 #endif
     }
 
+#ifdef LIBSTUD_JSON_STATISTICS
+    void parser::
+    update_stats (json_type e)
+    {
+      statistics& s (stats_);
+
+      const size_t p (json_get_position (impl_));
+      s.bytes = p;
+
+      const size_t d (json_get_depth (impl_));
+
+      if (const optional<event> te = translate (e))
+      {
+        s.events[static_cast<size_t> (*te) - 1]++;
+
+        if (d > s.max_depth)
+          s.max_depth = d;
+
+        if (e == JSON_STRING)
+        {
+          s.strings++;
+
+          // Determine whether the string contained escape sequences by
+          // checking for backslashes in the input consumed since the last
+          // check (a backslash can only appear inside a string).
+          //
+          bool esc;
+          if (stream_.is != nullptr || incremental_)
+          {
+            esc = stream_.backslashes != 0;
+            stream_.backslashes = 0;
+          }
+          else
+          {
+            const char* b (impl_->source.source.buffer.buffer);
+            esc = p > stats_scanned_ &&
+                  memchr (b + stats_scanned_, '\\', p - stats_scanned_) !=
+                  nullptr;
+          }
+
+          if (esc)
+            s.escaped_strings++;
+
+          if (impl_->data.string_size > s.string_buffer_size)
+            s.string_buffer_size = impl_->data.string_size;
+        }
+
+        // A complete top-level value.
+        //
+        if (d == 0 && *te != event::name && *te != event::begin_array &&
+            *te != event::begin_object)
+          s.values++;
+      }
+
+      stats_scanned_ = p;
+
+      // The stack only grows so each size change is a reallocation.
+      //
+      if (impl_->stack_size != stack_size_)
+      {
+        s.stack_reallocations++;
+        stack_size_ = impl_->stack_size;
+      }
+    }
+#endif
+
     optional<event> parser::
     translate (json_type e) const noexcept
     {
@@ -570,7 +1501,7 @@ namespace stud
     cache_parsed_data ()
     {
       name_p_ = value_p_ = false;
-      if (const optional<event> e = translate (*parsed_))
+      if (const optional<event> e = parsed_event_)
       {
         if (e == event::name)
         {
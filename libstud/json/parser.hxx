@@ -2,6 +2,7 @@
 
 #include <iosfwd>
 #include <string>
+#include <vector>
 #include <cstddef>   // size_t
 #include <cstdint>   // uint64_t
 #include <utility>   // pair
@@ -168,6 +169,51 @@ namespace stud
       parser& operator= (parser&&) = delete;
       parser& operator= (const parser&) = delete;
 
+      // Parsing limits.
+      //
+      // Limit the resources consumed while parsing untrusted input. A zero
+      // value means no limit. If a limit is exceeded, next() (and peek())
+      // throw invalid_json_input.
+      //
+      struct limits
+      {
+        // Maximum string (value or object member name, decoded) and number
+        // length in bytes.
+        //
+        std::size_t max_string = 0;
+
+        // Maximum array/object nesting depth. Note that it is also limited
+        // by the underlying parser implementation (currently 2048).
+        //
+        std::size_t max_depth = 0;
+
+        // Maximum number of input bytes consumed.
+        //
+        std::uint64_t max_bytes = 0;
+
+        // Maximum number of members in an object.
+        //
+        std::size_t max_members = 0;
+      };
+
+      // Set the parsing limits. Must be called before any events are parsed
+      // (including peeked) and std::invalid_argument is thrown otherwise.
+      //
+      // If storage is not NULL, then it is used as the buffer for decoding
+      // strings and numbers instead of allocating it dynamically, making the
+      // parser's peak memory usage known in advance. In this case strings
+      // and numbers that do not fit into this storage (including the
+      // terminating '\0') are treated as exceeding the max_string limit.
+      // Note that the underlying parser requests 1KB for this buffer
+      // initially and so the storage size must be at least 1024 bytes
+      // (std::invalid_argument is thrown otherwise). The storage must
+      // outlive the parser instance.
+      //
+      void
+      set_limits (const limits&,
+                  void* storage = nullptr,
+                  std::size_t storage_size = 0);
+
       // Event iteration.
       //
 
@@ -255,9 +301,84 @@ namespace stud
       // next(). The peeked values, however, can be accessed in the raw form
       // using data().
       //
+      // Note also that peeking does not copy the current name or value (the
+      // underlying parser's buffer is swapped instead) unless the fixed
+      // storage is used (see set_limits()).
+      //
       optional<event>
       peek ();
 
+      // Return true if the current JSON value has been started (that is, its
+      // first event has been returned by next() or peek()) but not yet
+      // ended (that is, the absent event that follows it has not yet been
+      // returned by next()).
+      //
+      // This function is primarily useful for skipping the rest of a value
+      // partially parsed by some other code, for example:
+      //
+      //     while (p.peek ())
+      //     {
+      //       handle_value (p); // May parse some, all, or none of it.
+      //
+      //       if (p.value_pending ())
+      //         while (p.next ()) ;
+      //     }
+      //
+      // Note that in this example handle_value() should not peek past the
+      // absent event that ends the value.
+      //
+      bool
+      value_pending () const noexcept
+      {
+        return (parsed_ && *parsed_ != JSON_DONE) ||
+               (peeked_ && *peeked_ != JSON_DONE);
+      }
+
+      // Batch event iteration.
+      //
+      // Parse up to n next events into the tokens array returning the number
+      // of events parsed. Return less than n only if the end of the value or
+      // input is reached, with 0 corresponding to next() returning nullopt.
+      // For example:
+      //
+      //     parser::token ts[256];
+      //     string d;
+      //     for (size_t n; (n = p.next_batch (ts, 256, d)) != 0; d.clear ())
+      //     {
+      //       for (size_t i (0); i != n; ++i)
+      //       {
+      //         const parser::token& t (ts[i]);
+      //         ... t.data, t.size ...
+      //       }
+      //     }
+      //
+      // Each token's data points to its raw value (or object member name)
+      // or is NULL for other events, similar to data(). If parsing a memory
+      // buffer, then the value is not copied and points into the buffer
+      // unless it is a string that contains escape sequences. Otherwise
+      // (for example, for a stream), it is appended to the data string and
+      // points into it. In both cases the data remains valid until the
+      // buffer is destroyed or the data string is modified.
+      //
+      // The depth is the number of arrays and objects containing the event
+      // with begin/end events having the depth of the array or object that
+      // they begin/end.
+      //
+      // After this call the name, value, location, and data correspond to
+      // the last event parsed (including absent), as if it was returned by
+      // next().
+      //
+      struct token
+      {
+        event type;
+        const char* data;
+        std::size_t size;
+        std::size_t depth;
+      };
+
+      std::size_t
+      next_batch (token*, std::size_t n, std::string& data);
+
 
       // Event data access.
       //
@@ -267,6 +388,46 @@ namespace stud
       const std::string&
       name ();
 
+      // Member name interning.
+      //
+      // Register the object member name in the per-parser dictionary (unless
+      // already registered) and return its id. Ids are assigned sequentially
+      // starting from 0 and remain valid for the lifetime of the parser.
+      // Normally all the names of interest are interned before parsing, for
+      // example:
+      //
+      //   const size_t id_name (p.intern ("name"));
+      //   const size_t id_size (p.intern ("size"));
+      //   ...
+      //   while (p.next_expect (event::name, event::end_object))
+      //   {
+      //     size_t id (p.name_id ());
+      //
+      //     if      (id == id_name) ...
+      //     else if (id == id_size) ...
+      //     else                    p.next_expect_value_skip ();
+      //   }
+      //
+      std::size_t
+      intern (const std::string&);
+
+      std::size_t
+      intern (const char*);
+
+      std::size_t
+      intern (const char*, std::size_t);
+
+      // Return the id of the object member name or std::string::npos if it
+      // is not interned. Unlike name(), this function does not copy the
+      // name.
+      //
+      // Note that names are not interned automatically so that the
+      // dictionary size does not depend on the (potentially untrusted)
+      // input.
+      //
+      std::size_t
+      name_id () const;
+
       // Any value (string, number, boolean, and null) can be retrieved as a
       // string. Calling this function after any non-value events is illegal.
       //
@@ -293,7 +454,21 @@ namespace stud
       // most recent event, whether peeked or parsed.
       //
       std::pair<const char*, std::size_t>
-      data () const {return std::make_pair (raw_s_, raw_n_);}
+      data () const
+      {
+        return peeked_
+          ? std::make_pair (peeked_s_, peeked_n_)
+          : std::make_pair (raw_s_, raw_n_);
+      }
+
+      // Decode the base64-encoded (RFC 4648, with padding) string value into
+      // the specified buffer returning the decoded data size. Throw
+      // invalid_json_input if the value is not valid base64 or if the
+      // decoded data does not fit into the buffer. Note that the buffer of
+      // data().second / 4 * 3 bytes is always sufficient.
+      //
+      std::size_t
+      value_base64 (void* buffer, std::size_t capacity) const;
 
 
       // Higher-level API suitable for parsing specific JSON vocabularies.
@@ -606,6 +781,56 @@ namespace stud
       std::uint64_t
       position () const noexcept;
 
+#ifdef LIBSTUD_JSON_STATISTICS
+      // Parsing statistics.
+      //
+      // Only available if the library is built with the statistics enabled
+      // (the config.libstud_json.statistics configuration variable), in which
+      // case LIBSTUD_JSON_STATISTICS is defined.
+      //
+      // Note that the statistics reflect the underlying parsing and so also
+      // include any peeked events.
+      //
+      struct statistics
+      {
+        // Input bytes consumed.
+        //
+        std::uint64_t bytes = 0;
+
+        // Events by type (the index is the event value minus 1).
+        //
+        std::uint64_t events[event_count] = {};
+
+        // Strings (values and object member names) decoded and those of them
+        // that contained escape sequences.
+        //
+        std::uint64_t strings = 0;
+        std::uint64_t escaped_strings = 0;
+
+        // Maximum array/object nesting depth.
+        //
+        std::size_t max_depth = 0;
+
+        // High-water mark of the underlying parser's string buffer size and
+        // the number of its nesting stack (re)allocations.
+        //
+        std::size_t string_buffer_size = 0;
+        std::uint64_t stack_reallocations = 0;
+
+        // Object member names and values copied to the name/value cache due
+        // to peek().
+        //
+        std::uint64_t peek_copies = 0;
+
+        // Complete top-level JSON values (records in the multi-value mode).
+        //
+        std::uint64_t values = 0;
+      };
+
+      const statistics&
+      stats () const noexcept {return stats_;}
+#endif
+
       // Implementation details.
       //
     public:
@@ -634,6 +859,10 @@ namespace stud
       {
         std::istream*                is;
         optional<std::exception_ptr> exception;
+
+#ifdef LIBSTUD_JSON_STATISTICS
+        std::uint64_t backslashes; // Number of backslashes read.
+#endif
       };
 
       [[noreturn]] void
@@ -641,6 +870,25 @@ namespace stud
 
       ~parser ();
 
+    protected:
+      // Incremental input (see incremental_parser for details).
+      //
+      struct incremental_tag {};
+
+      parser (incremental_tag,
+              const char* name,
+              bool multi_value,
+              const char* separators) noexcept;
+
+      void
+      feed (const void*, std::size_t);
+
+      void
+      finish () noexcept;
+
+      bool
+      ready ();
+
     private:
       // Functionality shared by next() and peek().
       //
@@ -675,6 +923,40 @@ namespace stud
 
       stream stream_;
 
+      // Incremental input (see incremental_parser for details).
+      //
+      // The input text that has been supplied but not yet read by the
+      // underlying parser is kept in the buffer starting from the read
+      // offset. The state of the scan performed by ready() is preserved
+      // between the calls so that a long token that arrives in many chunks
+      // is only scanned once.
+      //
+      enum class scan_state {skip, string, escape, literal, done};
+
+      struct incremental_input
+      {
+        std::string buffer;
+        std::size_t read = 0;
+
+        bool finished = false;
+        bool starved = false;    // Read past the end before finish().
+        bool separators = false; // Separators skipping is pending.
+
+        std::size_t scan_begin = 0; // Read offset at the beginning of scan.
+        std::size_t scan = 0;       // Offset of the next byte to scan.
+        std::size_t token = 0;      // Offset of the token being scanned.
+        scan_state state = scan_state::skip;
+      };
+
+      bool incremental_ = false;
+      incremental_input input_;
+
+      static int
+      incremental_get (void*);
+
+      static int
+      incremental_peek (void*);
+
       bool multi_value_;
       const char* separators_;
 
@@ -688,12 +970,170 @@ namespace stud
       optional<json_type> parsed_; // Current parsed event if any.
       optional<json_type> peeked_; // Current peeked event if any.
 
+      // Current parsed event translated when it was parsed (after a peek
+      // the underlying parser's context corresponds to the peeked event).
+      //
+      optional<event> parsed_event_;
+
       ::json_stream impl_[1];
 
-      // Cached raw value.
+      // Interned member names (see intern() for details).
+      //
+      // The names_ vector contains the names and their hashes in the id
+      // order. The name_slots_ open addressing hash table contains the name
+      // ids plus 1 (0 means empty slot). Its size is a power of 2 and it is
+      // kept at most half full.
+      //
+      std::vector<std::pair<std::string, std::uint64_t>> names_;
+      std::vector<std::size_t> name_slots_;
+
+      std::size_t
+      find_name (const char*, std::size_t, std::uint64_t hash) const;
+
+      // Cached raw value of the parsed event and of the peeked event, if
+      // any.
       //
       const char* raw_s_;
       std::size_t raw_n_;
+      const char* peeked_s_ = nullptr;
+      std::size_t peeked_n_ = 0;
+
+      // Spare string buffer for the underlying parser.
+      //
+      // When peeking, instead of copying the parsed string or number out of
+      // the underlying parser's buffer, we swap the buffer with the spare
+      // one so that both the parsed and peeked raw values remain valid.
+      //
+      char* spare_ = nullptr;
+      std::size_t spare_size_ = 0;
+
+      // Parsing limits (see set_limits() for details).
+      //
+      // If the limits are set, then the underlying parser's memory
+      // allocation functions are replaced in order to enforce the string
+      // length limit before the memory is allocated and to use the fixed
+      // storage, if any. The functions are called on the parser instance
+      // that is set as current for the calling thread.
+      //
+      limits limits_;
+      void* storage_ = nullptr;
+      std::size_t storage_size_ = 0;
+
+      // Set by the allocation functions if a limit is exceeded.
+      //
+      const char* limit_error_ = nullptr;
+
+      static void*
+      limits_malloc (std::size_t);
+
+      static void*
+      limits_realloc (void*, std::size_t);
+
+      static void
+      limits_free (void*);
+
+#ifdef LIBSTUD_JSON_STATISTICS
+      // Update the statistics for the event produced by the most recent call
+      // to next_impl().
+      //
+      void
+      update_stats (json_type);
+
+      statistics stats_;
+      std::size_t stats_scanned_ = 0; // Input scanned for backslashes.
+      std::size_t stack_size_ = 0;    // Last seen underlying stack size.
+#endif
+    };
+  }
+}
+
+namespace stud
+{
+  namespace json
+  {
+    // Parse JSON input text that becomes available incrementally, for
+    // example, as it is being read from a non-blocking socket.
+    //
+    // The underlying parser reads its input synchronously and cannot
+    // suspend in the middle of a token. So instead the input text is
+    // supplied (copied) with feed() as it arrives, the end of input is
+    // indicated with finish(), and before each call to next() or peek()
+    // (including the calls made by the higher-level API functions) ready()
+    // must be called to make sure that the next event can be parsed from
+    // the input supplied so far. If it returns false, then more input must
+    // be supplied or the end of input indicated. This allows parsing many
+    // inputs concurrently without blocking or a thread per input, for
+    // example, in a coroutine:
+    //
+    //   incremental_parser p ("<socket>");
+    //
+    //   for (;;)
+    //   {
+    //     if (!p.ready ())
+    //     {
+    //       size_t n (co_await sock.async_read (buf, sizeof (buf)));
+    //
+    //       if (n != 0)
+    //         p.feed (buf, n);
+    //       else
+    //         p.finish ();
+    //
+    //       continue;
+    //     }
+    //
+    //     optional<event> e (p.next ());
+    //
+    //     if (!e)
+    //       break;
+    //
+    //     ...
+    //   }
+    //
+    // The memory used for the input text is proportional to the length of
+    // the longest token (string, number, etc., including any whitespaces
+    // and separators preceding it) rather than of the entire value. If the
+    // max_string limit (or the fixed storage) is set, then an incomplete
+    // token that is already known to exceed it is diagnosed by next()
+    // without waiting for more input and the same goes for the max_bytes
+    // limit (see parser::set_limits() for details).
+    //
+    // Note that in the multi-value mode the separators that follow a value
+    // are skipped and checked by the next call to next() or peek() after the
+    // absent event that ends the value is returned (in the non-incremental
+    // mode this is done before returning this event). This way the absent
+    // event is available as soon as the value is complete.
+    //
+    class incremental_parser: public parser
+    {
+    public:
+      // See the parser's constructors for the semantics of the arguments.
+      //
+      explicit
+      incremental_parser (const std::string& name,
+                          bool multi_value = false,
+                          const char* separators = nullptr) noexcept;
+
+      explicit
+      incremental_parser (const char* name,
+                          bool multi_value = false,
+                          const char* separators = nullptr) noexcept;
+
+      incremental_parser (std::string&&,
+                          bool = false,
+                          const char* = nullptr) = delete;
+
+      // Supply the next chunk of the input text.
+      //
+      using parser::feed;
+
+      // Indicate that the end of input has been reached.
+      //
+      using parser::finish;
+
+      // Return true if the next event can be parsed (or, if invalid,
+      // diagnosed) from the input supplied so far.
+      //
+      using parser::ready;
     };
   }
 }
@@ -87,24 +87,52 @@ namespace stud
     {
     }
 
+    inline incremental_parser::
+    incremental_parser (const std::string& n,
+                        bool mv,
+                        const char* sep) noexcept
+        : parser (incremental_tag (), n.c_str (), mv, sep)
+    {
+    }
+
+    inline incremental_parser::
+    incremental_parser (const char* n,
+                        bool mv,
+                        const char* sep) noexcept
+        : parser (incremental_tag (), n, mv, sep)
+    {
+    }
+
     inline const std::string& parser::
     name ()
     {
       if (!name_p_)
       {
-        assert (parsed_ && !peeked_ && !value_p_);
+        assert (parsed_ && !value_p_);
         cache_parsed_data ();
         assert (name_p_);
       }
       return name_;
     }
 
+    inline std::size_t parser::
+    intern (const std::string& n)
+    {
+      return intern (n.data (), n.size ());
+    }
+
+    inline std::size_t parser::
+    intern (const char* s)
+    {
+      return intern (s, std::strlen (s));
+    }
+
     inline std::string& parser::
     value ()
     {
       if (!value_p_)
       {
-        assert (parsed_ && !peeked_ && !name_p_);
+        assert (parsed_ && !name_p_);
         cache_parsed_data ();
         assert (value_p_);
       }
@@ -206,7 +234,7 @@ namespace stud
     {
       if (!value_p_)
       {
-        assert (parsed_ && !peeked_ && value_event (translate (*parsed_)));
+        assert (parsed_ && value_event (parsed_event_));
         return parse_value<T> (raw_s_, raw_n_, *this);
       }
 
@@ -0,0 +1,213 @@
+#include <libstud/json/projection.hxx>
+
+#include <cstring>   // memcmp()
+#include <utility>   // move(), pair
+#include <stdexcept> // invalid_argument
+
+#include <libstud/json/reformat.hxx>
+
+using namespace std;
+
+namespace stud
+{
+  namespace json
+  {
+    projection::
+    projection (string m)
+        : mask_ (move (m))
+    {
+      nodes_.push_back (node {string (), action::none, false, {}});
+    }
+
+    void projection::
+    keep (const string& p)
+    {
+      add (p, action::keep);
+      whitelist_ = true;
+    }
+
+    void projection::
+    drop (const string& p)
+    {
+      add (p, action::drop);
+    }
+
+    void projection::
+    mask (const string& p)
+    {
+      add (p, action::mask);
+    }
+
+    void projection::
+    add (const string& p, action a)
+    {
+      size_t n (0); // Current node.
+      vector<size_t> path;
+
+      for (size_t b (0), e; ; b = e + 1)
+      {
+        e = p.find ('.', b);
+
+        if (e == string::npos)
+          e = p.size ();
+
+        if (e == b)
+          throw invalid_argument ("empty member name in path '" + p + '\'');
+
+        const node* c (find (nodes_[n], p.c_str () + b, e - b));
+
+        if (c != nullptr)
+          n = static_cast<size_t> (c - nodes_.data ());
+        else
+        {
+          // Note: may invalidate references to nodes.
+          //
+          nodes_.push_back (
+            node {string (p, b, e - b), action::none, false, {}});
+
+          size_t i (nodes_.size () - 1);
+          nodes_[n].children.push_back (i);
+          n = i;
+        }
+
+        path.push_back (n);
+
+        if (e == p.size ())
+          break;
+      }
+
+      if (nodes_[n].act != action::none)
+        throw invalid_argument ("duplicate path '" + p + '\'');
+
+      nodes_[n].act = a;
+
+      if (a == action::keep)
+      {
+        nodes_[0].keeps = true;
+        for (size_t i: path)
+          nodes_[i].keeps = true;
+      }
+    }
+
+    const projection::node* projection::
+    find (const node& n, const char* s, size_t z) const
+    {
+      for (size_t i: n.children)
+      {
+        const node& c (nodes_[i]);
+
+        if (c.name.size () == z && memcmp (c.name.c_str (), s, z) == 0)
+          return &c;
+      }
+
+      return nullptr;
+    }
+
+    void projection::
+    transform (parser& p, buffer_serializer& s, event e) const
+    {
+      transform (p, s, e, &nodes_[0], !whitelist_);
+    }
+
+    size_t projection::
+    transform (parser& p, buffer_serializer& s) const
+    {
+      size_t r (0);
+
+      while (p.peek ())
+      {
+        while (optional<event> e = p.next ())
+        {
+          transform (p, s, *e, &nodes_[0], !whitelist_);
+          r++;
+        }
+      }
+
+      return r;
+    }
+
+    // Transform the value of the specified node. If kept is false, then the
+    // value is only copied to the extent of the kept nodes (see keep()).
+    //
+    void projection::
+    transform (parser& p, buffer_serializer& s,
+               event e,
+               const node* n,
+               bool kept) const
+    {
+      // If there is nothing more specific for this value, then copy it as
+      // a whole.
+      //
+      if (n->children.empty ())
+      {
+        copy_value (p, s, e);
+        return;
+      }
+
+      switch (e)
+      {
+      case event::begin_array:
+        {
+          s.next (e);
+
+          while ((e = *p.next ()) != event::end_array)
+            transform (p, s, e, n, kept);
+
+          s.next (e);
+          break;
+        }
+      case event::begin_object:
+        {
+          s.next (e);
+
+          while ((e = *p.next ()) != event::end_object)
+          {
+            // Note: name's data is only valid until the next event.
+            //
+            const pair<const char*, size_t> d (p.data ());
+            const node* c (find (*n, d.first, d.second));
+
+            action a (c != nullptr ? c->act : action::none);
+
+            if (a == action::drop ||
+                (a == action::none && !kept && (c == nullptr || !c->keeps)))
+            {
+              p.next_expect_value_skip ();
+              continue;
+            }
+
+            copy_value (p, s, e); // Name.
+
+            if (a == action::mask)
+            {
+              p.next_expect_value_skip ();
+              s.value_json_text (mask_);
+              continue;
+            }
+
+            e = *p.next ();
+
+            if (c != nullptr)
+              transform (p, s, e, c, kept || a == action::keep);
+            else
+              copy_value (p, s, e);
+          }
+
+          s.next (e);
+          break;
+        }
+      case event::end_object:
+      case event::end_array:
+      case event::name:
+      case event::string:
+      case event::number:
+      case event::boolean:
+      case event::null:
+        {
+          copy_value (p, s, e);
+          break;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef> // size_t
+
+#include <libstud/json/event.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/serializer.hxx>
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Streaming projection and redaction of JSON values.
+    //
+    // The projection is specified as a set of object member paths, each
+    // being a sequence of member names separated with `.` (for example,
+    // `user.password`), and the corresponding actions:
+    //
+    // keep -- Retain the member (including its entire value). If any keep
+    //         paths are specified, then only the retained members (and the
+    //         objects containing them) are copied to the output.
+    //
+    // drop -- Remove the member. Its value is skipped without serializing.
+    //
+    // mask -- Replace the member value with the mask JSON text.
+    //
+    // Array elements are matched against the path of the array itself. For
+    // example, given `{"users":[{"name":"a","token":"b"}]}`, the
+    // `users.token` path refers to the token member in every element. A
+    // path that is a prefix of another is matched at every level, so, for
+    // example, drop or mask paths within a kept subtree are still applied.
+    //
+    // For example:
+    //
+    //   projection pr;
+    //   pr.keep ("id");
+    //   pr.keep ("user");
+    //   pr.mask ("user.password");
+    //
+    //   parser p (cin, "<stdin>", true /* multi_value */);
+    //   stream_serializer s (cout, 0);
+    //   pr.transform (p, s);
+    //
+    // Values that are not affected by the projection (for example, the
+    // entire value of a kept member that has no more specific paths) are
+    // copied with copy_value() (see reformat.hxx) and the memory used is
+    // proportional to the projection specification rather than the input.
+    //
+    class LIBSTUD_JSON_SYMEXPORT projection
+    {
+    public:
+      // The mask argument is the JSON text that replaces masked values.
+      // Note that it is copied to the output as is, without validation.
+      //
+      explicit
+      projection (std::string mask = "\"***\"");
+
+      // Add a path. Throw std::invalid_argument if the path is empty or
+      // contains an empty member name or if an action has already been
+      // specified for this path.
+      //
+      void
+      keep (const std::string& path);
+
+      void
+      drop (const std::string& path);
+
+      void
+      mask (const std::string& path);
+
+      // Transform the JSON value whose first event has just been returned by
+      // the parser's next() function (similar to copy_value()).
+      //
+      void
+      transform (parser&, buffer_serializer&, event first) const;
+
+      // Transform all the JSON values returning the number of values
+      // transformed (similar to reformat()).
+      //
+      std::size_t
+      transform (parser&, buffer_serializer&) const;
+
+    private:
+      enum class action {none, keep, drop, mask};
+
+      // Path tree node. The root node corresponds to the top-level value.
+      //
+      struct node
+      {
+        std::string name;
+        action act;
+        bool keeps; // This or a descendant node is kept.
+        std::vector<std::size_t> children;
+      };
+
+      void
+      add (const std::string& path, action);
+
+      const node*
+      find (const node&, const char* name, std::size_t size) const;
+
+      void
+      transform (parser&, buffer_serializer&,
+                 event first, const node*, bool kept) const;
+
+      std::string mask_;
+      bool whitelist_ = false;
+      std::vector<node> nodes_;
+    };
+  }
+}
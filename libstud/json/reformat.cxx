@@ -0,0 +1,102 @@
+#include <libstud/json/reformat.hxx>
+
+#include <utility> // pair
+
+using namespace std;
+
+namespace stud
+{
+  namespace json
+  {
+    // Return true if the decoded string contains characters that must be
+    // escaped when serialized. Note that the UTF-8 validity has already
+    // been verified by the parser.
+    //
+    static inline bool
+    escape (const pair<const char*, size_t>& v)
+    {
+      for (const char* p (v.first), *e (v.first + v.second); p != e; ++p)
+      {
+        const unsigned char c (static_cast<unsigned char> (*p));
+
+        if (c == '"' || c == '\\' || c <= 0x1F)
+          return true;
+      }
+
+      return false;
+    }
+
+    static inline void
+    copy_event (parser& p, buffer_serializer& s, event e)
+    {
+      switch (e)
+      {
+      case event::name:
+      case event::string:
+        {
+          const pair<const char*, size_t> v (p.data ());
+          s.next (e, v, escape (v));
+          break;
+        }
+      case event::number:
+      case event::boolean:
+      case event::null:
+        s.next (e, p.data (), false /* check */);
+        break;
+      case event::begin_object:
+      case event::end_object:
+      case event::begin_array:
+      case event::end_array:
+        s.next (e);
+        break;
+      }
+    }
+
+    void
+    copy_value (parser& p, buffer_serializer& s, event e)
+    {
+      size_t depth (0);
+
+      for (;;)
+      {
+        copy_event (p, s, e);
+
+        switch (e)
+        {
+        case event::begin_object:
+        case event::begin_array:  depth++; break;
+        case event::end_object:
+        case event::end_array:    depth--; break;
+        default:                           break;
+        }
+
+        if (depth == 0)
+          break;
+
+        // The parser guarantees the structure is complete (or throws).
+        //
+        e = *p.next ();
+      }
+    }
+
+    size_t
+    reformat (parser& p, buffer_serializer& s)
+    {
+      size_t r (0);
+
+      // Note that in the multi-value mode the parser returns nullopt after
+      // every value (see parser::next() for details).
+      //
+      while (p.peek ())
+      {
+        while (optional<event> e = p.next ())
+        {
+          copy_value (p, s, *e);
+          r++;
+        }
+      }
+
+      return r;
+    }
+  }
+}
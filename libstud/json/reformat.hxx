@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef> // size_t
+
+#include <libstud/optional.hxx> // stud::optional is std::optional or similar.
+
+#include <libstud/json/event.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/serializer.hxx>
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Copy the JSON value whose first event has just been returned by the
+    // parser's next() function to the serializer. If the value is an array
+    // or object, then also copy all the nested events up to and including
+    // the corresponding end event. For example, to copy an object member:
+    //
+    //   p.next_expect_name ("data");
+    //   s.member_name ("data");
+    //   copy_value (p, s, *p.next ());
+    //
+    // The data of events that have already been validated by the parser is
+    // passed to the serializer as is, without UTF-8 checking. Strings and
+    // object member names that contain characters that must be escaped are
+    // serialized with checking enabled.
+    //
+    LIBSTUD_JSON_SYMEXPORT void
+    copy_value (parser&, buffer_serializer&, event first);
+
+    // Copy all the JSON values from the parser to the serializer returning
+    // the number of values copied. This function can be used to minify or
+    // pretty-print JSON input text (depending on the serializer's
+    // indentation) as well as to normalize JSON value sequences, such as
+    // NDJSON, when the parser is in the multi-value mode (depending on the
+    // serializer's multi-value separator).
+    //
+    // Note that this function does not finalize the serializer's value
+    // sequence (with an absent event) so that additional values can be
+    // serialized after it returns.
+    //
+    LIBSTUD_JSON_SYMEXPORT std::size_t
+    reformat (parser&, buffer_serializer&);
+  }
+}
@@ -1,3 +1,13 @@
+#ifndef _WIN32
+#  include <unistd.h>  // write(), fsync()
+#  include <sys/uio.h> // writev(), iovec
+#else
+#  include <io.h>      // _write(), _commit()
+#endif
+
+#include <cerrno>
+#include <climits>  // INT_MAX
+#include <cstdint>  // uintptr_t
 #include <cstdio>   // snprintf
 #include <cstdarg>  // va_list
 #include <cstring>  // memcpy, strlen
@@ -59,6 +69,134 @@ namespace stud
       size_ = v.size ();
     }
 
+    block_buffer::
+    block_buffer (size_t bs)
+        : block_size_ (bs)
+    {
+    }
+
+    size_t block_buffer::
+    size () const
+    {
+      size_t r (0);
+      for (const block& b: blocks_)
+        r += b.size;
+      return r;
+    }
+
+    void block_buffer::
+    copy (void* d) const
+    {
+      char* p (static_cast<char*> (d));
+      for (const block& b: blocks_)
+      {
+        memcpy (p, b.data, b.size);
+        p += b.size;
+      }
+    }
+
+    std::string block_buffer::
+    string () const
+    {
+      std::string r;
+      r.reserve (size ());
+      for (const block& b: blocks_)
+        r.append (b.data, b.size);
+      return r;
+    }
+
+    void block_buffer::
+    clear ()
+    {
+      for (size_t i (0); i != blocks_.size (); ++i)
+        free_.push_back (block {blocks_[i].data, capacities_[i]});
+
+      blocks_.clear ();
+      capacities_.clear ();
+    }
+
+    void block_buffer::
+    overflow (void* d, event, buffer& b, size_t extra)
+    {
+      block_buffer& bb (*static_cast<block_buffer*> (d));
+
+      // A block must be able to hold at least the extra space requested
+      // (for example, a multi-value separator that is longer than the block
+      // size) so allocate a larger block if necessary.
+      //
+      size_t n (extra > bb.block_size_ ? extra : bb.block_size_);
+
+      // Note that the free list and the block lists all have the capacity to
+      // hold all the blocks ever allocated so the only operation that may
+      // throw is the allocation of a new block.
+      //
+      // Reuse the most recently freed block that is large enough, if any.
+      //
+      size_t i (bb.free_.size ());
+      while (i != 0 && bb.free_[i - 1].size < n)
+        --i;
+
+      char* p;
+      if (i == 0)
+      {
+        // Grow the capacity geometrically to keep the amortized cost of
+        // allocating a block constant.
+        //
+        if (bb.storage_.size () == bb.storage_.capacity ())
+        {
+          size_t c (bb.storage_.size () != 0 ? bb.storage_.size () * 2 : 8);
+
+          bb.storage_.reserve (c);
+          bb.free_.reserve (c);
+          bb.blocks_.reserve (c);
+          bb.capacities_.reserve (c);
+        }
+
+        bb.storage_.emplace_back (new char[n]);
+        p = bb.storage_.back ().get ();
+      }
+      else
+      {
+        block& f (bb.free_[i - 1]);
+        p = f.data;
+        n = f.size;
+
+        f = bb.free_.back ();
+        bb.free_.pop_back ();
+      }
+
+      if (!bb.blocks_.empty ())
+        bb.blocks_.back ().size = b.size;
+
+      bb.blocks_.push_back (block {p, 0});
+      bb.capacities_.push_back (n);
+
+      b.data = p;
+      b.size = 0;
+      b.capacity = n;
+    }
+
+    void block_buffer::
+    flush (void* d, event, buffer& b)
+    {
+      block_buffer& bb (*static_cast<block_buffer*> (d));
+      bb.blocks_.back ().size = b.size;
+    }
+
+    buffer_serializer::
+    buffer_serializer (block_buffer& bb, size_t i, const char* mvs)
+        : buffer_serializer (
+            bb.blocks_.empty () ? nullptr : bb.blocks_.back ().data,
+            size_,
+            bb.blocks_.empty () ? 0 : bb.capacities_.back (),
+            block_buffer::overflow,
+            block_buffer::flush,
+            &bb,
+            i, mvs)
+    {
+      size_ = bb.blocks_.empty () ? 0 : bb.blocks_.back ().size;
+    }
+
     static void
     ostream_overflow (void* d, event e, buffer& b, size_t)
     {
@@ -92,21 +230,415 @@ namespace stud
     {
     }
 
+    // Write the data to the file descriptor handling partial writes and
+    // interruptions.
+    //
+    static void
+    fd_write (int fd, optional<event> e, const char* d, size_t n)
+    {
+      while (n != 0)
+      {
+#ifndef _WIN32
+        ssize_t r (write (fd, d, n));
+#else
+        int r (_write (fd, d, static_cast<unsigned int> (n < INT_MAX
+                                                         ? n
+                                                         : INT_MAX)));
+#endif
+        if (r < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          throw invalid_json_output (
+            e, error_code::buffer_overflow, "unable to write JSON output text");
+        }
+
+        d += r;
+        n -= static_cast<size_t> (r);
+      }
+    }
+
+    void fd_serializer::
+    overflow (void* d, event e, buffer& b, size_t)
+    {
+      fd_serializer& s (*static_cast<fd_serializer*> (d));
+
+      // Allocate the buffer on the first write.
+      //
+      if (b.data == nullptr)
+      {
+        const size_t a (s.buffer_alignment_ != 0 ? s.buffer_alignment_ : 1);
+
+        s.storage_.reset (new char[s.buffer_size_ + a - 1]);
+
+        uintptr_t p (reinterpret_cast<uintptr_t> (s.storage_.get ()));
+        b.data = reinterpret_cast<char*> ((p + a - 1) / a * a);
+        b.capacity = s.buffer_size_;
+        return;
+      }
+
+      // In the aligned mode only write whole blocks moving the remainder to
+      // the beginning of the buffer.
+      //
+      char* p (static_cast<char*> (b.data));
+      size_t n (b.size);
+
+      if (s.buffer_alignment_ != 0)
+        n -= n % s.buffer_alignment_;
+
+      fd_write (s.fd_, e, p, n);
+
+      if (n != b.size)
+        memmove (p, p + n, b.size - n);
+
+      b.size -= n;
+    }
+
+    // Synchronize the file state with the storage device.
+    //
+    static void
+    fd_sync (int fd, optional<event> e)
+    {
+#ifndef _WIN32
+      if (fsync (fd) != 0)
+#else
+      if (_commit (fd) != 0)
+#endif
+        throw invalid_json_output (
+          e, error_code::buffer_overflow, "unable to sync JSON output text");
+    }
+
+    void fd_serializer::
+    flush_value (void* d, event e, buffer& b)
+    {
+      fd_serializer& s (*static_cast<fd_serializer*> (d));
+
+      // Unless requested, keep buffering the output text across values (for
+      // example, to write a sequence of small values with one system call).
+      //
+      if (!s.flush_values && !s.sync)
+        return;
+
+      overflow (d, e, b, 0);
+
+      if (s.sync)
+        fd_sync (s.fd_, e);
+    }
+
+    void fd_serializer::
+    flush (bool sync)
+    {
+      fd_write (fd_, nullopt, static_cast<char*> (buf_.data), buf_.size);
+      buf_.size = 0;
+      unmark ();
+
+      if (sync)
+        fd_sync (fd_, nullopt);
+    }
+
+    void fd_serializer::
+    gather (void* d, event e, buffer& b, const char* c, size_t n)
+    {
+      int fd (static_cast<fd_serializer*> (d)->fd_);
+
+#ifndef _WIN32
+      iovec v[2] {{b.data, b.size}, {const_cast<char*> (c), n}};
+
+      for (iovec* i (b.size != 0 ? v : v + 1); i != v + 2; )
+      {
+        ssize_t r (writev (fd, i, static_cast<int> (v + 2 - i)));
+
+        if (r < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          throw invalid_json_output (
+            e, error_code::buffer_overflow, "unable to write JSON output text");
+        }
+
+        // Skip over what has been written, which could be a partial buffer.
+        //
+        for (size_t w (static_cast<size_t> (r)); i != v + 2; ++i)
+        {
+          if (w < i->iov_len)
+          {
+            i->iov_base = static_cast<char*> (i->iov_base) + w;
+            i->iov_len -= w;
+            break;
+          }
+
+          w -= i->iov_len;
+        }
+      }
+#else
+      fd_write (fd, e, static_cast<char*> (b.data), b.size);
+      fd_write (fd, e, c, n);
+#endif
+
+      b.size = 0;
+    }
+
+    fd_serializer::
+    fd_serializer (int fd,
+                   size_t i, const char* mvs,
+                   size_t bs, size_t ba,
+                   size_t gt)
+        : buffer_serializer (nullptr, 0,
+                             overflow,
+                             flush_value,
+                             this,
+                             i, mvs),
+          fd_ (fd),
+          buffer_size_ (ba != 0 ? (bs + ba - 1) / ba * ba : bs),
+          buffer_alignment_ (ba)
+    {
+      // In the aligned mode the remainder (which is less than one block) is
+      // kept in the buffer after a write so at least one more block is
+      // required to make progress.
+      //
+      if (ba != 0 && buffer_size_ < 2 * ba)
+        throw invalid_argument ("fd_serializer buffer size must be at least "
+                                "twice the alignment");
+
+      if (gt != 0 && ba == 0)
+      {
+        gather_ = gather;
+        gather_min_ = gt;
+      }
+    }
+
+    fd_serializer::
+    ~fd_serializer ()
+    {
+      try
+      {
+        fd_write (fd_, nullopt, static_cast<char*> (buf_.data), buf_.size);
+      }
+      catch (const invalid_json_output&)
+      {
+        // Ignore (see the flush_values documentation).
+      }
+    }
+
+    // nonblocking_serializer
+    //
+    void nonblocking_serializer::
+    write_out ()
+    {
+      char* p (static_cast<char*> (buf_.data));
+      size_t n (written_);
+
+      while (n != buf_.size)
+      {
+        size_t r (write_ (write_data_, p + n, buf_.size - n));
+
+        if (r == 0)
+          break;
+
+        n += r;
+      }
+
+      if (n == written_)
+        return;
+
+      // The output text that has been written cannot be rolled back.
+      //
+      unmark ();
+
+      // Rather than moving the remainder to the beginning of the buffer
+      // after every (potentially partial) write, which is quadratic, only do
+      // it once the remainder is no longer than what has been written. This
+      // way the amount of data moved does not exceed the amount written.
+      //
+      if (n == buf_.size)
+      {
+        buf_.size = 0;
+        written_ = 0;
+      }
+      else if (n >= buf_.size - n)
+      {
+        memmove (p, p + n, buf_.size - n);
+        buf_.size -= n;
+        written_ = 0;
+      }
+      else
+        written_ = n;
+    }
+
+    void nonblocking_serializer::
+    overflow (void* d, event e, buffer& b, size_t ex)
+    {
+      nonblocking_serializer& s (*static_cast<nonblocking_serializer*> (d));
+      size_t m (s.max_pending_);
+
+      // Allocate the buffer on the first write.
+      //
+      if (b.data == nullptr)
+      {
+        size_t c (s.buffer_size_ > ex ? s.buffer_size_ : ex);
+        if (m != 0 && c > m)
+          c = m;
+
+        s.storage_.reset (new char[c]);
+        b.data = s.storage_.get ();
+        b.capacity = c;
+      }
+      else
+      {
+        s.write_out ();
+
+        // If the sink would block, then grow the buffer (but not beyond the
+        // high-water mark) keeping what's pending and dropping what has
+        // been written.
+        //
+        if (b.capacity - b.size < ex)
+        {
+          size_t n (b.size - s.written_);
+
+          size_t c (b.capacity * 2);
+          if (c < n + ex)
+            c = n + ex;
+          if (m != 0 && c > m)
+            c = m;
+
+          if (c > b.capacity)
+          {
+            unique_ptr<char[]> p (new char[c]);
+            memcpy (p.get (), static_cast<char*> (b.data) + s.written_, n);
+
+            s.storage_ = move (p);
+            b.data = s.storage_.get ();
+            b.size = n;
+            b.capacity = c;
+            s.written_ = 0;
+          }
+          else if (s.written_ != 0)
+          {
+            char* p (static_cast<char*> (b.data));
+            memmove (p, p + s.written_, n);
+            b.size = n;
+            s.written_ = 0;
+          }
+        }
+      }
+
+      // With the high-water mark we may not be able to provide all the
+      // extra space requested, which is fine as long as there is enough to
+      // write the next chunk of output text. Since values are written in
+      // chunks, we only insist on the space for the longest sequence that
+      // is not broken (an escaped Unicode sequence, \uXXXX).
+      //
+      if (m != 0 && b.capacity - b.size < (ex < 6 ? ex : 6))
+        throw invalid_json_output (e,
+                                   error_code::buffer_overflow,
+                                   "pending output text limit exceeded");
+    }
+
+    void nonblocking_serializer::
+    flush_value (void* d, event, buffer&)
+    {
+      static_cast<nonblocking_serializer*> (d)->write_out ();
+    }
+
+    bool nonblocking_serializer::
+    flush ()
+    {
+      write_out ();
+      return buf_.size == 0;
+    }
+
+    size_t nonblocking_serializer::
+    write_fd (void* d, const char* p, size_t n)
+    {
+      int fd (static_cast<nonblocking_serializer*> (d)->fd_);
+
+      for (;;)
+      {
+#ifndef _WIN32
+        ssize_t r (::write (fd, p, n));
+#else
+        int r (_write (fd, p, static_cast<unsigned int> (n < INT_MAX
+                                                         ? n
+                                                         : INT_MAX)));
+#endif
+        if (r < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+#ifndef _WIN32
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+#endif
+          throw invalid_json_output (
+            nullopt,
+            error_code::buffer_overflow,
+            "unable to write JSON output text");
+        }
+
+        return static_cast<size_t> (r);
+      }
+    }
+
+    nonblocking_serializer::
+    nonblocking_serializer (write_function* w, void* wd,
+                            size_t i, const char* mvs,
+                            size_t bs, size_t mp)
+        : buffer_serializer (nullptr, 0,
+                             overflow,
+                             flush_value,
+                             this,
+                             i, mvs),
+          write_ (w),
+          write_data_ (wd),
+          written_ (0),
+          fd_ (-1),
+          buffer_size_ (bs != 0 ? bs : 1),
+          max_pending_ (mp)
+    {
+    }
+
+    nonblocking_serializer::
+    nonblocking_serializer (int fd,
+                            size_t i, const char* mvs,
+                            size_t bs, size_t mp)
+        : nonblocking_serializer (write_fd, this, i, mvs, bs, mp)
+    {
+      fd_ = fd;
+    }
+
     bool buffer_serializer::
     next (optional<event> e, pair<const char*, size_t> val, bool check)
+    {
+      return next (e, val, check, '\0');
+    }
+
+    bool buffer_serializer::
+    next (optional<event> e,
+          pair<const char*, size_t> val,
+          bool check,
+          char part)
     {
       if (absent_ == 2)
         goto fail_complete;
 
       if (e == nullopt)
       {
-        if (!state_.empty ())
+        if (state_.size () != base_ || member_incomplete () || string_)
           goto fail_incomplete;
 
         absent_++;
         return false;
       }
 
+      // Only the end of the incrementally serialized string can follow its
+      // beginning.
+      //
+      if (string_ && part != 'e')
+        goto fail_unexpected_event;
+
       absent_ = 0; // Clear inter-value absent event.
 
       {
@@ -229,9 +761,9 @@ namespace stud
         case event::end_array:
         case event::end_object:
           {
-            if (st == nullptr || (e == event::end_array
-                                  ? st->type != event::begin_array
-                                  : !name_expected (*st)))
+            if (state_.size () == base_ || (e == event::end_array
+                                            ? st->type != event::begin_array
+                                            : !name_expected (*st)))
               goto fail_unexpected_event;
 
             write (*e,
@@ -243,17 +775,34 @@ namespace stud
               sep_.erase (sep_.size () - indent_);
 
             state_.pop_back ();
+
+            if (state_.size () < mark_.depth)
+              unmark ();
             break;
           }
         case event::name:
         case event::string:
           {
-            if (e == event::name
-                ? (st == nullptr || !name_expected (*st))
-                : (st != nullptr && name_expected (*st)))
+            if (part != 'e' &&
+                (e == event::name
+                 ? (st == nullptr || !name_expected (*st))
+                 : (st != nullptr && name_expected (*st))))
               goto fail_unexpected_event;
 
-            write (*e, sep, val, check, '"');
+            if (part == '\0')
+              write (*e, sep, val, check, '"');
+            else
+            {
+              write (*e,
+                     part == 'b' ? sep : make_str (nullptr, 0),
+                     make_str ("\"", 1),
+                     false);
+
+              // The string is incomplete so neither is the value.
+              //
+              if (part == 'b')
+                return true;
+            }
 
             if (st != nullptr)
               st->count++;
@@ -300,11 +849,26 @@ namespace stud
         }
       }
 
-      if (state_.empty ())
+      if (state_.size () == base_ && !member_incomplete ())
       {
         values_++;
         if (flush_ != nullptr)
+        {
+          size_t n (buf_.size);
+
+#ifndef LIBSTUD_JSON_STATISTICS
+          flush_ (data_, *e, buf_);
+#else
+          auto t (chrono::steady_clock::now ());
           flush_ (data_, *e, buf_);
+          stats_.flush_time += chrono::steady_clock::now () - t;
+          stats_.flush_calls++;
+          stats_.flush_bytes += n;
+#endif
+
+          if (buf_.size < n)
+            unmark ();
+        }
 
         return false;
       }
@@ -328,6 +892,293 @@ namespace stud
           e, error_code::unexpected_event, "unexpected event");
     }
 
+    void buffer_serializer::
+    begin_fragment (const buffer_serializer& p, size_t n)
+    {
+      if (!state_.empty () || values_ != 0 || absent_ != 1)
+        throw invalid_json_output (nullopt,
+                                   error_code::unexpected_event,
+                                   "serializer is not in initial state");
+
+      if (indent_ != p.indent_)
+        throw invalid_json_output (
+          nullopt, error_code::unexpected_event, "indentation mismatch");
+
+      const state* st (p.state_.empty () ? nullptr : &p.state_.back ());
+
+      if (st == nullptr || p.string_ ||
+          (st->type == event::begin_object && st->count % 2 == 1))
+        throw invalid_json_output (
+          nullopt, error_code::unexpected_event, "not inside array or object");
+
+      // We only need the state of the innermost array or object since we
+      // are not going to leave it.
+      //
+      state_.push_back (
+        state {st->type, st->type == event::begin_object ? n * 2 : n});
+
+      base_ = 1;
+      sep_ = p.sep_;
+    }
+
+    void buffer_serializer::
+    splice_fragment (const void* t, size_t s, size_t n)
+    {
+      state* st (state_.empty () ? nullptr : &state_.back ());
+
+      if (st == nullptr || string_ ||
+          (st->type == event::begin_object && st->count % 2 == 1))
+        throw invalid_json_output (
+          nullopt, error_code::unexpected_event, "not inside array or object");
+
+      // Similar to value_json_text(), use event::number with a disabled
+      // check.
+      //
+      // Note that the fragment text already contains the separators.
+      //
+      if (s != 0)
+        write (event::number,
+               pair<const char*, size_t> (nullptr, 0),
+               make_pair (static_cast<const char*> (t), s),
+               false /* check */);
+
+      st->count += st->type == event::begin_object ? n * 2 : n;
+    }
+
+    void buffer_serializer::
+    begin_string (bool c)
+    {
+      next (event::string, make_pair (nullptr, 0), false, 'b');
+      string_ = event::string;
+      string_check_ = c;
+    }
+
+    void buffer_serializer::
+    begin_member_name (bool c)
+    {
+      next (event::name, make_pair (nullptr, 0), false, 'b');
+      string_ = event::name;
+      string_check_ = c;
+    }
+
+    // Return the length of a UTF-8 sequence given its first byte. Invalid
+    // first bytes are treated as complete sequences and are diagnosed by
+    // write().
+    //
+    static inline size_t
+    utf8_length (char c)
+    {
+      const uint8_t u (c);
+      return u >= 0xF0 && u <= 0xF4 ? 4 :
+             u >= 0xE0 && u <= 0xEF ? 3 :
+             u >= 0xC2 && u <= 0xDF ? 2 : 1;
+    }
+
+    void buffer_serializer::
+    append_string (const char* d, size_t n)
+    {
+      if (!string_)
+        throw invalid_json_output (
+          event::string, error_code::unexpected_event, "unexpected event");
+
+      const pair<const char*, size_t> nosep (nullptr, 0);
+
+      if (!string_check_)
+      {
+        if (n != 0)
+          write (*string_, nosep, make_pair (d, n), false);
+
+        return;
+      }
+
+      // First complete the UTF-8 sequence left over from the previous
+      // chunk, if any. Note that we don't check whether the added bytes
+      // are continuation bytes: if not, then write() will diagnose it.
+      //
+      if (utf8_size_ != 0)
+      {
+        size_t l (utf8_length (utf8_[0]));
+
+        for (; utf8_size_ != l && n != 0; --n)
+          utf8_[utf8_size_++] = *d++;
+
+        if (utf8_size_ != l)
+          return;
+
+        utf8_size_ = 0;
+        write (*string_, nosep, make_pair (utf8_, l), true);
+      }
+
+      // Then set aside the incomplete UTF-8 sequence at the end of this
+      // chunk, if any.
+      //
+      for (size_t i (n); i != 0 && n - i != 4; )
+      {
+        const uint8_t u (d[--i]);
+
+        if (u < 0x80 || u > 0xBF) // Not a continuation byte.
+        {
+          if (n - i < utf8_length (d[i]))
+          {
+            utf8_size_ = n - i;
+            memcpy (utf8_, d + i, utf8_size_);
+            n = i;
+          }
+          break;
+        }
+      }
+
+      if (n != 0)
+        write (*string_, nosep, make_pair (d, n), true);
+    }
+
+    void buffer_serializer::
+    end_string ()
+    {
+      if (!string_)
+        throw invalid_json_output (
+          event::string, error_code::unexpected_event, "unexpected event");
+
+      event e (*string_);
+
+      if (utf8_size_ != 0)
+        throw invalid_json_output (e,
+                                   e == event::name
+                                   ? error_code::invalid_name
+                                   : error_code::invalid_value,
+                                   "invalid UTF-8 text");
+
+      next (e, make_pair (nullptr, 0), false, 'e');
+      string_ = nullopt;
+    }
+
+    void buffer_serializer::
+    mark ()
+    {
+      mark_.size = buf_.size;
+      mark_.depth = state_.size ();
+      mark_.count = state_.empty () ? 0 : state_.back ().count;
+      mark_.sep = sep_.size ();
+      mark_.values = values_;
+      mark_.absent = absent_;
+      mark_.string = string_;
+      mark_.utf8_size = utf8_size_;
+      memcpy (mark_.utf8, utf8_, utf8_size_);
+    }
+
+    bool buffer_serializer::
+    rollback ()
+    {
+      if (mark_.size == string::npos || buf_.size < mark_.size)
+        return false;
+
+      // Since none of the arrays and objects that were open at the time of
+      // the mark could have been closed (see end_* in next()), the states
+      // below the mark depth are unchanged and any above it were opened
+      // after the mark. The same reasoning applies to the indentation in
+      // sep_.
+      //
+      buf_.size = mark_.size;
+      while (state_.size () != mark_.depth)
+        state_.pop_back ();
+
+      if (!state_.empty ())
+        state_.back ().count = mark_.count;
+
+      sep_.resize (mark_.sep);
+      values_ = mark_.values;
+      absent_ = mark_.absent;
+      string_ = mark_.string;
+      utf8_size_ = mark_.utf8_size;
+      memcpy (utf8_, mark_.utf8, utf8_size_);
+
+      // For the in-memory targets the flush function merely updates the
+      // target's size to that of the buffer (and writes nothing out), so
+      // call it to discard any rolled back output that has already been
+      // reflected in the target.
+      //
+      if (buf_.data != nullptr &&
+          (flush_ == dynarray_flush<string>       ||
+           flush_ == dynarray_flush<vector<char>> ||
+           flush_ == block_buffer::flush))
+        flush_ (data_, event::null /* unused */, buf_);
+
+      return true;
+    }
+
+    void buffer_serializer::
+    value_base64 (const void* d, size_t n)
+    {
+      static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+      const uint8_t* p (static_cast<const uint8_t*> (d));
+
+      begin_string (false /* check */);
+
+      for (;;)
+      {
+        size_t cap (buf_.capacity - buf_.size);
+
+        char* b (static_cast<char*> (buf_.data) + buf_.size);
+        char* o (b);
+
+        // Encode as many complete 3-byte groups as fit into the buffer.
+        //
+        size_t m (min (n / 3, cap / 4));
+        for (const uint8_t* e (p + m * 3); p != e; p += 3, o += 4)
+        {
+          uint32_t v ((uint32_t (p[0]) << 16) |
+                      (uint32_t (p[1]) << 8)  |
+                       uint32_t (p[2]));
+
+          o[0] = alphabet[v >> 18];
+          o[1] = alphabet[(v >> 12) & 0x3F];
+          o[2] = alphabet[(v >> 6) & 0x3F];
+          o[3] = alphabet[v & 0x3F];
+        }
+
+        n -= m * 3;
+        cap -= m * 4;
+
+        // Encode the remaining 1 or 2 bytes, if any, with padding.
+        //
+        if (n != 0 && n < 3 && cap >= 4)
+        {
+          uint32_t v ((uint32_t (p[0]) << 16) |
+                      (n == 2 ? uint32_t (p[1]) << 8 : 0));
+
+          o[0] = alphabet[v >> 18];
+          o[1] = alphabet[(v >> 12) & 0x3F];
+          o[2] = n == 2 ? alphabet[(v >> 6) & 0x3F] : '=';
+          o[3] = '=';
+
+          o += 4;
+          cap -= 4;
+          n = 0;
+        }
+
+        buf_.size += o - b;
+
+#ifdef LIBSTUD_JSON_STATISTICS
+        stats_.bytes += o - b;
+#endif
+
+        if (n == 0)
+          break;
+
+        // Request enough space for the rest of the encoded value.
+        //
+        size_t extra ((n + 2) / 3 * 4 - cap);
+        if (!call_overflow (event::string, extra > 4 ? extra : 4, 4))
+          throw invalid_json_output (event::string,
+                                     error_code::buffer_overflow,
+                                     "insufficient space in buffer");
+      }
+
+      end_string ();
+    }
+
     // JSON escape sequences for control characters <= 0x1F.
     //
     static const char* json_escapes[] =
@@ -365,15 +1216,12 @@ namespace stud
 
       auto grow = [this, e, &size, &cap] (size_t min, size_t extra = 0)
       {
-        if (overflow_ == nullptr)
-          return false;
-
         extra += size;
         extra -= cap;
-        overflow_ (data_, e, buf_, extra > min ? extra : min);
-        cap = buf_.capacity - buf_.size;
 
-        return cap >= min;
+        bool r (call_overflow (e, extra > min ? extra : min, min));
+        cap = buf_.capacity - buf_.size;
+        return r;
       };
 
       auto append = [this, &cap, &size] (const char* d, size_t s)
@@ -382,6 +1230,10 @@ namespace stud
         buf_.size += s;
         cap -= s;
         size -= s;
+
+#ifdef LIBSTUD_JSON_STATISTICS
+        stats_.bytes += s;
+#endif
       };
 
       // Return the longest chunk of input that fits into the buffer and does
@@ -607,6 +1459,46 @@ namespace stud
       {
         pair<const char*, size_t> ch (nullptr, 0);
 
+        // If the remainder of the value is large enough, try to pass its
+        // next chunk to the gather function instead of copying it into the
+        // buffer. Escape sequences and chunks that turn out to be too short
+        // are handled in the usual way below.
+        //
+        if (gather_ != nullptr && val.second >= gather_min_)
+        {
+          const uint8_t c (val.first[0]);
+
+          if (!check || (c != '"' && c != '\\' && c > 0x1F))
+          {
+            const pair<const char*, size_t> v (val);
+            const size_t n (cap);
+
+            cap = val.second; // Chunk the entire remainder.
+            ch = check ? chunk_checked () : chunk ();
+            cap = n;
+
+            if (ch.second == string::npos)
+              goto fail_utf8;
+
+            if (ch.second >= gather_min_)
+            {
+              gather_ (data_, e, buf_, ch.first, ch.second);
+              cap = buf_.capacity - buf_.size;
+              unmark ();
+
+#ifdef LIBSTUD_JSON_STATISTICS
+              stats_.gather_calls++;
+              stats_.bytes += ch.second;
+#endif
+              size -= ch.second;
+              continue;
+            }
+
+            val = v;
+            ch = {nullptr, 0};
+          }
+        }
+
         if (cap != 0)
           ch = check ? chunk_checked () : chunk ();
 
@@ -622,7 +1514,18 @@ namespace stud
             goto fail_nospace;
         }
         else if (ch.second != string::npos)
+        {
           append (ch.first, ch.second);
+
+#ifdef LIBSTUD_JSON_STATISTICS
+          // With checking enabled, the value's backslashes are themselves
+          // escaped so a chunk can only start with one if it is an escape
+          // sequence.
+          //
+          if (check && ch.first[0] == '\\')
+            stats_.escapes++;
+#endif
+        }
         else
           goto fail_utf8;
       }
@@ -637,6 +1540,11 @@ namespace stud
         append ("\"", 1);
       }
 
+#ifdef LIBSTUD_JSON_STATISTICS
+      if (check)
+        stats_.checked_bytes += vn;
+#endif
+
       return;
 
       // Note: keep descriptions consistent with the parser.
@@ -653,6 +1561,99 @@ namespace stud
           e, error_code::buffer_overflow, "insufficient space in buffer");
     }
 
+    bool buffer_serializer::
+    call_overflow (event e, size_t extra, size_t min)
+    {
+      if (overflow_ == nullptr)
+        return false;
+
+      size_t n (buf_.size);
+
+#ifndef LIBSTUD_JSON_STATISTICS
+      overflow_ (data_, e, buf_, extra);
+#else
+      auto t (chrono::steady_clock::now ());
+      overflow_ (data_, e, buf_, extra);
+      stats_.overflow_time += chrono::steady_clock::now () - t;
+      stats_.overflow_calls++;
+#endif
+
+      if (buf_.size < n)
+        unmark ();
+
+      return buf_.capacity - buf_.size >= min;
+    }
+
+    void buffer_serializer::
+    write_array_block (const char* b, size_t n, size_t c)
+    {
+      // Note: value_array() has just opened the array so it is the innermost
+      // state.
+      //
+      state& st (state_.back ());
+
+      // Skip the comma before the first element.
+      //
+      size_t o (st.count == 0 ? 1 : 0);
+
+      write (event::number,
+             pair<const char*, size_t> (nullptr, 0),
+             make_pair (b + o, n - o),
+             false /* check */);
+
+      st.count += c;
+    }
+
+    size_t buffer_serializer::
+    to_chars_integer (char* b, size_t n, unsigned long long v, bool neg)
+    {
+      // Convert two digits at a time, from the end.
+      //
+      static const char digits[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+      char t[24]; // 20 digits plus sign.
+      char* e (t + sizeof (t));
+      char* p (e);
+
+      for (; v >= 100; v /= 100)
+      {
+        const char* d (digits + (v % 100) * 2);
+        *--p = d[1];
+        *--p = d[0];
+      }
+
+      if (v >= 10)
+      {
+        const char* d (digits + v * 2);
+        *--p = d[1];
+        *--p = d[0];
+      }
+      else
+        *--p = static_cast<char> ('0' + v);
+
+      if (neg)
+        *--p = '-';
+
+      // Keep the same semantics as to_chars_impl() (space for the trailing
+      // '\0', which we don't write).
+      //
+      size_t r (static_cast<size_t> (e - p));
+      if (r >= n)
+      {
+        throw invalid_json_output (event::number,
+                                   error_code::invalid_value,
+                                   "unable to convert number to string");
+      }
+
+      memcpy (b, p, r);
+      return r;
+    }
+
     size_t buffer_serializer::
     to_chars_impl (char* b, size_t n, const char* f, ...)
     {
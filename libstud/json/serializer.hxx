@@ -2,6 +2,7 @@
 
 #include <array>
 #include <iosfwd>
+#include <memory>      // unique_ptr
 #include <string>
 #include <vector>
 #include <cstddef>     // size_t, nullptr_t
@@ -9,6 +10,11 @@
 #include <stdexcept>   // invalid_argument
 #include <type_traits> // enable_if, is_*
 
+#ifdef LIBSTUD_JSON_STATISTICS
+#  include <chrono>
+#  include <cstdint>   // uint64_t
+#endif
+
 #include <libstud/optional.hxx> // stud::optional is std::optional or similar.
 
 #include <libstud/json/event.hxx>
@@ -54,6 +60,8 @@ namespace stud
       std::size_t          offset;
     };
 
+    class block_buffer;
+
     // The serializer makes sure the resulting JSON is syntactically but not
     // necessarily semantically correct. For example, it's possible to
     // serialize a number event with non-numeric data.
@@ -95,6 +103,17 @@ namespace stud
                          std::size_t indentation = 2,
                          const char* multi_value_separator = "\n");
 
+      // Serialize to a chain of fixed-size blocks. Note that the result is
+      // appended to any existing data in the buffer.
+      //
+      // Unlike std::string and std::vector, growing such a buffer does not
+      // involve copying the output text serialized so far.
+      //
+      explicit
+      buffer_serializer (block_buffer&,
+                         std::size_t indentation = 2,
+                         const char* multi_value_separator = "\n");
+
       // Serialize to a fixed array.
       //
       // The length of the output text written is tracked in the size
@@ -156,6 +175,23 @@ namespace stud
                                       std::size_t extra);
       using flush_function    = void (void* data, event, buffer&);
 
+      // The gather function, if set by a derived serializer (see
+      // fd_serializer for an example), is called instead of copying a large
+      // chunk of a string value into the buffer. The chunk is guaranteed not
+      // to require any escaping (or it was requested not to be checked). The
+      // function is passed the buffer with the output text preceding the
+      // chunk as well as the chunk itself and is expected to write both to
+      // the output destination (for example, with a single writev() call),
+      // returning (by modifying the argument) the buffer with the space made
+      // available, similar to the overflow function. Note that the chunk
+      // data is only valid for the duration of the call.
+      //
+      using gather_function = void (void* data,
+                                    event,
+                                    buffer&,
+                                    const char* chunk,
+                                    std::size_t size);
+
       // Serialize using a custom buffer and overflow/flush functions (both
       // are optional).
       //
@@ -258,6 +294,35 @@ namespace stud
                               std::is_floating_point<T>::value>::type
       value (T);
 
+      // Serialize an array of numbers.
+      //
+      // Semantically equivalent to begin_array(), value(T) for each element,
+      // and end_array() but the elements are formatted in blocks which are
+      // then written into the buffer at once, bypassing the per-value state
+      // machine, separator, and capacity handling.
+      //
+      template <typename T>
+      typename std::enable_if<(std::is_integral<T>::value &&
+                               !std::is_same<T, bool>::value) ||
+                              std::is_floating_point<T>::value>::type
+      value_array (const T*, std::size_t);
+
+      template <typename T>
+      void
+      value_array (const std::vector<T>&);
+
+      // Serialize binary data as a base64-encoded (RFC 4648, with padding)
+      // string.
+      //
+      // The data is encoded directly into the buffer in complete 4-character
+      // groups without checking since the base64 alphabet does not require
+      // escaping. If the buffer has no space for the next group, then the
+      // overflow function is called requesting enough space for the rest of
+      // the value.
+      //
+      void
+      value_base64 (const void*, std::size_t);
+
       // Serialize a boolean value.
       //
       void
@@ -280,6 +345,33 @@ namespace stud
       void
       value_json_text (const std::string&);
 
+      // Serialize a string value or object member name incrementally.
+      //
+      // Begin the string with begin_string() or begin_member_name(), append
+      // its contents with one or more append_string() calls, and finish it
+      // with end_string(). Nothing else can be serialized in between. The
+      // contents are validated and escaped as they are appended and a UTF-8
+      // sequence may be split between the calls. This allows serializing a
+      // large value without first assembling it in memory.
+      //
+      // If check is false, then don't check whether the string is valid
+      // UTF-8 and don't escape any characters.
+      //
+      void
+      begin_string (bool check = true);
+
+      void
+      begin_member_name (bool check = true);
+
+      void
+      append_string (const char*, std::size_t);
+
+      void
+      append_string (const std::string&);
+
+      void
+      end_string ();
+
       // Serialize next JSON event.
       //
       // If check is false, then don't check whether the value is valid UTF-8
@@ -329,13 +421,174 @@ namespace stud
             std::pair<const char*, std::size_t> value = {},
             bool check = true);
 
+      // Fragment serialization.
+      //
+      // A fragment is a sequence of array elements or object members that is
+      // serialized separately (for example, on another thread) and is later
+      // spliced into the containing array or object. For example:
+      //
+      //   string b;
+      //   buffer_serializer s (b);
+      //   s.begin_array ();
+      //
+      //   string f1, f2;
+      //   buffer_serializer s1 (f1), s2 (f2);
+      //   s1.begin_fragment (s, 0);    // Elements [0, 1000).
+      //   s2.begin_fragment (s, 1000); // Elements [1000, 2000).
+      //
+      //   // Serialize elements with s1 and s2, potentially in parallel.
+      //
+      //   s.splice_fragment (f1, 1000);
+      //   s.splice_fragment (f2, 1000);
+      //   s.end_array ();
+      //
+      // Begin serializing a fragment of the array or object that the parent
+      // serializer is currently inside of as if the specified number of
+      // elements or members have already been serialized into it. This
+      // function must be called on a serializer in the initial state (that
+      // is, before anything has been serialized with it) and that has the
+      // same indentation as the parent. The necessary state is copied from
+      // the parent so the parent can continue to be used.
+      //
+      // After this call only complete elements or members can be serialized,
+      // each of them being treated as a value for the purpose of flushing
+      // and value completeness checking (see next() for details).
+      //
+      void
+      begin_fragment (const buffer_serializer& parent, std::size_t count);
+
+      // Splice the fragment text containing the specified number of elements
+      // or members into the array or object that this serializer is
+      // currently inside of. Fragments must be spliced in order with each
+      // fragment's count passed to begin_fragment() matching the number of
+      // elements or members spliced (or otherwise serialized) before it.
+      //
+      void
+      splice_fragment (const void* text, std::size_t size, std::size_t count);
+
+      void
+      splice_fragment (const std::string& text, std::size_t count);
+
+      // Checkpoint and rollback.
+      //
+      // Mark the current position in the output (buffer contents as well as
+      // the serialization state) so that anything serialized after it can
+      // later be discarded with rollback(), for example, if an error is
+      // detected halfway through serializing a record. Calling mark() again
+      // replaces the previous mark.
+      //
+      // Rolling back is only possible if the output after the mark is still
+      // in the buffer. Specifically, the mark is invalidated if the overflow
+      // or flush function (or the gather function) writes any of the buffer
+      // contents out as well as if any array or object that was open at the
+      // time of the mark is closed.
+      //
+      void
+      mark ();
+
+      // Roll back to the mark returning true on success and false if there
+      // is no mark or it has been invalidated (see above). The mark remains
+      // valid after a successful rollback.
+      //
+      // If serializing to std::string, std::vector, or block_buffer, then
+      // the rolled back output is also removed from the target.
+      //
+      bool
+      rollback ();
+
+#ifdef LIBSTUD_JSON_STATISTICS
+      // Serialization statistics.
+      //
+      // Only available if the library is built with the statistics enabled
+      // (see parser::stats() for details).
+      //
+      struct statistics
+      {
+        using duration = std::chrono::steady_clock::duration;
+
+        // Bytes of JSON text written (into the buffer or passed to the
+        // gather function).
+        //
+        std::uint64_t bytes = 0;
+
+        // Escape sequences generated and bytes of values (including numbers
+        // and object member names) serialized with checking enabled.
+        //
+        std::uint64_t escapes = 0;
+        std::uint64_t checked_bytes = 0;
+
+        // Overflow function calls and the time spent in them.
+        //
+        std::uint64_t overflow_calls = 0;
+        duration overflow_time = duration::zero ();
+
+        // Flush function calls, the total number of buffered bytes they were
+        // called with (so flush_bytes / flush_calls is the average number of
+        // bytes per flush), and the time spent in them.
+        //
+        std::uint64_t flush_calls = 0;
+        std::uint64_t flush_bytes = 0;
+        duration flush_time = duration::zero ();
+
+        // Gather function calls.
+        //
+        std::uint64_t gather_calls = 0;
+      };
+
+      const statistics&
+      stats () const noexcept {return stats_;}
+#endif
+
+    protected:
+      // Output buffer (see buffer above for details).
+      //
+      buffer buf_;
+
+      // Gather function and the minimum chunk size it should be called for
+      // (see gather_function above for details).
+      //
+      gather_function* gather_ = nullptr;
+      std::size_t gather_min_ = 0;
+
+      // Invalidate the mark (see mark() for details). Should be called by
+      // derived serializers that write the buffer contents out other than
+      // from the overflow, flush, or gather functions.
+      //
+      void
+      unmark ();
+
     private:
+      // Implementation of next(). The part argument is used to serialize
+      // the opening ('b') or closing ('e') quote of an incrementally
+      // serialized string or member name (see begin_string() for details)
+      // and is '\0' otherwise.
+      //
+      bool
+      next (optional<event>,
+            std::pair<const char*, std::size_t>,
+            bool check,
+            char part);
+
       void
       write (event,
              std::pair<const char*, std::size_t> sep,
              std::pair<const char*, std::size_t> val,
              bool check, char quote = '\0');
 
+      // Call the overflow function requesting the specified number of extra
+      // bytes and return true if there is now space for at least min bytes.
+      // Return false if there is no overflow function.
+      //
+      bool
+      call_overflow (event, std::size_t extra, std::size_t min);
+
+      // Write a block of array elements formatted by value_array(), each
+      // preceded by the non-first element separator, and increment the
+      // array element count accordingly.
+      //
+      void
+      write_array_block (const char*, std::size_t size, std::size_t count);
+
       // Forward a value(v, check) call to value(v) ignoring the check
       // argument. Used in the member() implementation.
       //
@@ -358,8 +611,10 @@ namespace stud
       static std::size_t to_chars (char*, std::size_t, long double);
 
       static std::size_t to_chars_impl (char*, size_t, const char* fmt, ...);
+      static std::size_t to_chars_integer (char*, std::size_t,
+                                           unsigned long long,
+                                           bool negative);
 
-      buffer buf_;
       std::size_t size_;
       overflow_function* overflow_;
       flush_function* flush_;
@@ -402,11 +657,132 @@ namespace stud
       //
       std::size_t values_ = 0;
 
+      // The number of nested structured type states that are outside of the
+      // value being serialized, which is non-zero only when serializing a
+      // fragment (see begin_fragment()). In this case these are the states
+      // of the containing arrays and objects and the values are their
+      // elements or members.
+      //
+      std::size_t base_ = 0;
+
+      bool
+      member_incomplete () const;
+
+      // Incrementally serialized string or member name, if any (see
+      // begin_string() for details). The incomplete UTF-8 sequence at the
+      // end of the last appended chunk, if any, is kept in utf8_.
+      //
+      optional<event> string_;
+      bool string_check_;
+      char utf8_[4];
+      std::size_t utf8_size_ = 0;
+
+      // Mark state (see mark() for details). The size member is npos if
+      // there is no valid mark.
+      //
+      struct checkpoint
+      {
+        std::size_t size = std::string::npos;
+        std::size_t depth = 0; // Number of states.
+        std::size_t count;     // Count of the innermost state, if any.
+        std::size_t sep;       // Size of sep_.
+        std::size_t values;
+        std::size_t absent;
+        optional<event> string;
+        char utf8[4];
+        std::size_t utf8_size;
+      };
+
+      checkpoint mark_;
+
+#ifdef LIBSTUD_JSON_STATISTICS
+      statistics stats_;
+#endif
+
       // Multi-value separator.
       //
       const char* mv_separator_;
     };
 
+    // Output buffer consisting of a chain of fixed-size blocks that are
+    // filled in order and are never reallocated or moved (see the
+    // buffer_serializer constructor above for details). A block larger than
+    // the block size is allocated if a single write (for example, of an
+    // indentation or multi-value separator) would not otherwise fit.
+    //
+    // The blocks are allocated on demand and are recycled by clear(), so the
+    // same buffer can be reused, for example, to serialize a response for
+    // each request without any further allocations once the largest response
+    // has been serialized.
+    //
+    class LIBSTUD_JSON_SYMEXPORT block_buffer
+    {
+    public:
+      explicit
+      block_buffer (std::size_t block_size = 65536);
+
+      block_buffer (block_buffer&&) = delete;
+      block_buffer (const block_buffer&) = delete;
+
+      block_buffer& operator= (block_buffer&&) = delete;
+      block_buffer& operator= (const block_buffer&) = delete;
+
+      // The blocks containing the output text, in order. Note that the size
+      // of the last block is only updated once the complete JSON value has
+      // been serialized. Note also that, except for the last one, blocks may
+      // not be filled to capacity.
+      //
+      // The blocks can be written out directly (for example, by converting
+      // them to the iovec list for writev()) or copied out with copy() or
+      // string() below.
+      //
+      struct block
+      {
+        char*       data;
+        std::size_t size;
+      };
+
+      const std::vector<block>&
+      blocks () const {return blocks_;}
+
+      // Return the total size of the output text.
+      //
+      std::size_t
+      size () const;
+
+      // Copy the output text into the buffer, which should be at least size()
+      // bytes long.
+      //
+      void
+      copy (void* buf) const;
+
+      std::string
+      string () const;
+
+      // Discard the output text keeping the blocks for reuse. Note that the
+      // buffer should not be in use by a serializer during this call.
+      //
+      void
+      clear ();
+
+    private:
+      friend class buffer_serializer;
+
+      using buffer = buffer_serializer::buffer;
+
+      static void
+      overflow (void*, event, buffer&, std::size_t);
+
+      static void
+      flush (void*, event, buffer&);
+
+      std::size_t block_size_;
+      std::vector<block> blocks_;
+      std::vector<std::size_t> capacities_; // Of blocks_.
+      std::vector<block> free_;             // Size is capacity.
+      std::vector<std::unique_ptr<char[]>> storage_;
+    };
+
     class LIBSTUD_JSON_SYMEXPORT stream_serializer: public buffer_serializer
     {
     public:
@@ -424,6 +800,186 @@ namespace stud
     protected:
       char tmp_[4096];
     };
+
+    class LIBSTUD_JSON_SYMEXPORT fd_serializer: public buffer_serializer
+    {
+    public:
+      // Serialize to a file descriptor. Note that the file descriptor is not
+      // closed by the serializer.
+      //
+      // Input/output errors are reported as the invalid_json_output
+      // exception.
+      //
+      // The buffer_size argument specifies the size of the output buffer,
+      // which is allocated on the first write. The output text is written
+      // to the file descriptor directly from this buffer, without any
+      // intermediate copies (for example, into the stream buffer in case of
+      // stream_serializer).
+      //
+      // If buffer_alignment is not 0, then the buffer is aligned on this
+      // boundary, its size is rounded up to a multiple of it, and the output
+      // text is written in multiples of this size, keeping the remainder in
+      // the buffer until the next write (see flush() below for how to write
+      // the remainder). This, for example, makes it possible to write to a
+      // file opened with O_DIRECT, in which case the alignment should
+      // normally be the file system block size and the buffer size should be
+      // at least several blocks. The buffer size must be at least twice the
+      // alignment (std::invalid_argument is thrown otherwise).
+      //
+      // String values (or their parts that don't require escaping) that are
+      // at least gather_threshold bytes long are not copied into the buffer.
+      // Instead, they are written to the file descriptor directly together
+      // with the preceding buffered output text using a single writev() call.
+      // If gather_threshold is 0 or buffer_alignment is not 0, then this
+      // optimization is disabled.
+      //
+      explicit
+      fd_serializer (int fd,
+                     std::size_t indentation = 2,
+                     const char* multi_value_separator = "\n",
+                     std::size_t buffer_size = 4096,
+                     std::size_t buffer_alignment = 0,
+                     std::size_t gather_threshold = 16384);
+
+      ~fd_serializer ();
+
+      // If true, then write the buffered output text every time a complete
+      // JSON value has been serialized (for example, for interactive
+      // consumers). Otherwise, the output text is only written when the
+      // buffer is full, on flush(), and on destruction (in which case any
+      // errors are ignored; call flush() to detect them).
+      //
+      bool flush_values = false;
+
+      // If true, then also synchronize the file state with the storage
+      // device (fsync()) every time a complete JSON value has been
+      // serialized. Implies flush_values.
+      //
+      bool sync = false;
+
+      // Write any buffered output text, including the remainder in the
+      // aligned mode, and, if requested, synchronize the file state with the
+      // storage device. Note that in case of O_DIRECT, the remainder may not
+      // be a multiple of the block size and the flag may have to be cleared
+      // (see fcntl()) before calling this function.
+      //
+      void
+      flush (bool sync = false);
+
+    protected:
+      int fd_;
+      std::size_t buffer_size_;
+      std::size_t buffer_alignment_;
+      std::unique_ptr<char[]> storage_;
+
+    private:
+      static void
+      overflow (void*, event, buffer&, std::size_t);
+
+      static void
+      flush_value (void*, event, buffer&);
+
+      static void
+      gather (void*, event, buffer&, const char*, std::size_t);
+    };
+
+    class LIBSTUD_JSON_SYMEXPORT nonblocking_serializer: public buffer_serializer
+    {
+    public:
+      // Serialize to a sink that may not be able to accept all the output
+      // text at once, such as a non-blocking socket or pipe.
+      //
+      // The write function should write as much of the passed data as it
+      // can without blocking and return the number of bytes written, with
+      // 0 meaning the sink would block. It can report input/output errors
+      // by throwing an exception (presumably, invalid_json_output).
+      //
+      // Instead of blocking, the output text that could not be written is
+      // kept in the buffer, which is grown as necessary. Normally, the
+      // caller would serialize a unit of output (a complete value, an array
+      // element, etc), check the amount of pending() output against its
+      // limit and, if exceeded, wait for the sink to become writable and
+      // call flush() until it returns true. Note that a long string value
+      // can be serialized in chunks with begin_string() and append_string()
+      // in order to keep the buffer bounded.
+      //
+      // The buffer_size argument specifies the initial size of the output
+      // buffer, which is allocated on the first write.
+      //
+      // The max_pending argument, if not 0, specifies the high-water mark
+      // for the pending output text: the buffer is never larger than that
+      // and, if the sink would block and there is no more space in the
+      // buffer, invalid_json_output (with the buffer_overflow code) is
+      // thrown. The caller can then wait for the sink to become writable,
+      // call flush(), and serialize the unit of output again, having first
+      // discarded its partially serialized output text with rollback() (see
+      // mark() for details). Note that rollback() fails if some of that
+      // output text has already been written.
+      //
+      // Note also that the output text that is still pending when the
+      // serializer is destroyed is discarded. To make sure everything has
+      // been written, call flush() until it returns true before that.
+      //
+      using write_function = std::size_t (void* data, const char*, std::size_t);
+
+      nonblocking_serializer (write_function*,
+                              void* data,
+                              std::size_t indentation = 2,
+                              const char* multi_value_separator = "\n",
+                              std::size_t buffer_size = 16384,
+                              std::size_t max_pending = 0);
+
+      // Serialize to a file descriptor that has been put into the
+      // non-blocking mode (O_NONBLOCK). Note that the file descriptor is not
+      // closed by the serializer. Input/output errors (other than EAGAIN or
+      // EWOULDBLOCK) are reported as the invalid_json_output exception.
+      //
+      // Note that on Windows the writes are always blocking.
+      //
+      explicit
+      nonblocking_serializer (int fd,
+                              std::size_t indentation = 2,
+                              const char* multi_value_separator = "\n",
+                              std::size_t buffer_size = 16384,
+                              std::size_t max_pending = 0);
+
+      // Write as much of the buffered output text as possible returning
+      // true if everything has been written and false if the sink would
+      // block.
+      //
+      bool
+      flush ();
+
+      // Return the amount of the buffered output text that has not yet been
+      // written.
+      //
+      std::size_t
+      pending () const {return buf_.size - written_;}
+
+    protected:
+      write_function* write_;
+      void* write_data_;
+      std::size_t written_; // Written part at the beginning of the buffer.
+      int fd_;
+      std::size_t buffer_size_;
+      std::size_t max_pending_;
+      std::unique_ptr<char[]> storage_;
+
+      // Write as much of the buffered output text as possible.
+      //
+      void
+      write_out ();
+
+    private:
+      static void
+      overflow (void*, event, buffer&, std::size_t);
+
+      static void
+      flush_value (void*, event, buffer&);
+
+      static std::size_t
+      write_fd (void*, const char*, std::size_t);
+    };
   }
 }
 
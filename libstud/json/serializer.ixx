@@ -1,4 +1,4 @@
-#include <cstring> // strlen()
+#include <cstring> // strlen(), memcpy()
 
 namespace stud
 {
@@ -157,6 +157,12 @@ namespace stud
       next (event::string, {v.c_str (), v.size ()}, c);
     }
 
+    inline void buffer_serializer::
+    append_string (const std::string& v)
+    {
+      append_string (v.c_str (), v.size ());
+    }
+
     template <typename T>
     typename std::enable_if<std::is_integral<T>::value ||
                             std::is_floating_point<T>::value>::type
@@ -171,6 +177,64 @@ namespace stud
       next (event::number, {b, n});
     }
 
+    template <typename T>
+    typename std::enable_if<(std::is_integral<T>::value &&
+                             !std::is_same<T, bool>::value) ||
+                            std::is_floating_point<T>::value>::type
+    buffer_serializer::
+    value_array (const T* v, std::size_t n)
+    {
+      begin_array ();
+
+      // Format the elements, each preceded by the separator, into blocks
+      // and write each block at once (see write_array_block() for details).
+      //
+      const bool pp (indent_ != 0);
+      const char* s (pp ? sep_.c_str () : ",");
+      const std::size_t sn (pp ? sep_.size () : 1);
+
+      char b[4096];
+
+      // See value(T) for the maximum number size. Fall back to serializing
+      // one element at a time if the block cannot fit even a single element
+      // (extremely deep nesting with pretty-printing).
+      //
+      if (sn + 40 > sizeof (b))
+      {
+        for (std::size_t i (0); i != n; ++i)
+          value (v[i]);
+      }
+      else
+      {
+        std::size_t bn (0), bc (0);
+        for (std::size_t i (0); i != n; ++i)
+        {
+          if (sizeof (b) - bn < sn + 40)
+          {
+            write_array_block (b, bn, bc);
+            bn = bc = 0;
+          }
+
+          std::memcpy (b + bn, s, sn);
+          bn += sn;
+          bn += to_chars (b + bn, 40, v[i]);
+          bc++;
+        }
+
+        if (bc != 0)
+          write_array_block (b, bn, bc);
+      }
+
+      end_array ();
+    }
+
+    template <typename T>
+    inline void buffer_serializer::
+    value_array (const std::vector<T>& v)
+    {
+      value_array (v.data (), v.size ());
+    }
+
     inline void buffer_serializer::
     value (bool b)
     {
@@ -199,40 +263,73 @@ namespace stud
       next (event::number, {v.c_str (), v.size ()}, false /* check */);
     }
 
+    inline bool buffer_serializer::
+    member_incomplete () const
+    {
+      // Only possible in a fragment of an object where we have the name but
+      // not yet the value of a member.
+      //
+      return base_ != 0                                 &&
+             state_.size () == base_                    &&
+             state_.back ().type == event::begin_object &&
+             state_.back ().count % 2 == 1;
+    }
+
+    inline void buffer_serializer::
+    unmark ()
+    {
+      mark_.size = std::string::npos;
+    }
+
+    inline void buffer_serializer::
+    splice_fragment (const std::string& t, std::size_t n)
+    {
+      splice_fragment (t.c_str (), t.size (), n);
+    }
+
     inline size_t buffer_serializer::
     to_chars (char* b, size_t s, int v)
     {
-      return to_chars_impl (b, s, "%d", v);
+      using ull = unsigned long long;
+      return v < 0
+        ? to_chars_integer (b, s, 0ULL - static_cast<ull> (v), true)
+        : to_chars_integer (b, s, static_cast<ull> (v), false);
     }
 
     inline size_t buffer_serializer::
     to_chars (char* b, size_t s, long v)
     {
-      return to_chars_impl (b, s, "%ld", v);
+      using ull = unsigned long long;
+      return v < 0
+        ? to_chars_integer (b, s, 0ULL - static_cast<ull> (v), true)
+        : to_chars_integer (b, s, static_cast<ull> (v), false);
     }
 
     inline size_t buffer_serializer::
     to_chars (char* b, size_t s, long long v)
     {
-      return to_chars_impl (b, s, "%lld", v);
+      using ull = unsigned long long;
+      return v < 0
+        ? to_chars_integer (b, s, 0ULL - static_cast<ull> (v), true)
+        : to_chars_integer (b, s, static_cast<ull> (v), false);
     }
 
     inline size_t buffer_serializer::
     to_chars (char* b, size_t s, unsigned v)
     {
-      return to_chars_impl (b, s, "%u", v);
+      return to_chars_integer (b, s, v, false);
     }
 
     inline size_t buffer_serializer::
     to_chars (char* b, size_t s, unsigned long v)
     {
-      return to_chars_impl (b, s, "%lu", v);
+      return to_chars_integer (b, s, v, false);
     }
 
     inline size_t buffer_serializer::
     to_chars (char* b, size_t s, unsigned long long v)
     {
-      return to_chars_impl (b, s, "%llu", v);
+      return to_chars_integer (b, s, v, false);
     }
 
     inline size_t buffer_serializer::
@@ -0,0 +1,234 @@
+#include <libstud/json/splitter.hxx>
+
+#include <cstring> // strchr()
+
+#include <libstud/json/parser.hxx> // invalid_json_input
+
+namespace stud
+{
+  namespace json
+  {
+    using namespace std;
+
+    value_splitter::
+    value_splitter (const char* n, const char* sep, size_t max)
+        : name_ (n), separators_ (sep), max_size_ (max)
+    {
+    }
+
+    void value_splitter::
+    feed (const void* d, size_t n)
+    {
+      // Discard the text of the values already returned if it is at least
+      // half of the buffer (so that we don't keep moving large incomplete
+      // values).
+      //
+      if (begin_ != 0 && begin_ * 2 >= buf_.size ())
+      {
+        // Count the columns of the text being discarded (see
+        // advance_column()).
+        //
+        advance_column (position_ + begin_);
+
+        buf_.erase (0, begin_);
+        position_ += begin_;
+        scan_ -= begin_;
+        begin_ = 0;
+      }
+
+      buf_.append (static_cast<const char*> (d), n);
+    }
+
+    // Count the columns from the column position (or the current line
+    // beginning, whichever is greater) to the specified position. Note that
+    // columns are counted in UTF-8 code points, that is, continuation bytes
+    // (10xxxxxx) are not counted.
+    //
+    void value_splitter::
+    advance_column (uint64_t p)
+    {
+      if (line_position_ > column_position_)
+      {
+        column_position_ = line_position_;
+        column_ = 1;
+      }
+
+      for (; column_position_ < p; ++column_position_)
+      {
+        unsigned char c (buf_[column_position_ - position_]);
+
+        if ((c & 0xC0) != 0x80)
+          ++column_;
+      }
+    }
+
+    void value_splitter::
+    finish ()
+    {
+      finished_ = true;
+    }
+
+    static inline bool
+    json_space (char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static inline bool
+    literal_char (char c)
+    {
+      return (c >= '0' && c <= '9') ||
+             (c >= 'a' && c <= 'z') ||
+             (c >= 'A' && c <= 'Z') ||
+             c == '-' || c == '+' || c == '.';
+    }
+
+    bool value_splitter::
+    next (pair<const char*, size_t>& r)
+    {
+      const char* s (buf_.data ());
+      size_t n (buf_.size ());
+      size_t i (scan_);
+      size_t e; // End of the value.
+
+      auto newline = [this] (size_t i)
+      {
+        ++line_;
+        line_position_ = position_ + i + 1;
+      };
+
+      // Skip separators and whitespaces preceding the value and determine
+      // its kind by the first character.
+      //
+      if (kind_ == kind::none)
+      {
+        for (; i != n; ++i)
+        {
+          char c (s[i]);
+
+          if (c == '\n')
+            newline (i);
+          else if (!json_space (c) &&
+                   (separators_ == nullptr ||
+                    c == '\0'              ||
+                    strchr (separators_, c) == nullptr))
+            break;
+        }
+
+        begin_ = scan_ = i;
+
+        if (i == n)
+          return false;
+
+        value_line_ = line_;
+        value_position_ = position_ + i;
+        advance_column (value_position_);
+        value_column_ = column_;
+
+        char c (s[i++]);
+        kind_ = (c == '{' || c == '[' ? kind::structured :
+                 c == '"'             ? kind::string     :
+                                        kind::literal);
+        depth_ = 1;
+        string_ = kind_ == kind::string;
+        escape_ = false;
+      }
+
+      if (kind_ == kind::literal)
+      {
+        for (; i != n; ++i)
+        {
+          if (!literal_char (s[i]))
+          {
+            e = i;
+            goto done;
+          }
+        }
+      }
+      else
+      {
+        for (; i != n; ++i)
+        {
+          char c (s[i]);
+
+          if (c == '\n')
+            newline (i); // Invalid inside a string but let parser diagnose.
+
+          if (string_)
+          {
+            if (escape_)
+              escape_ = false;
+            else if (c == '\\')
+              escape_ = true;
+            else if (c == '"')
+            {
+              string_ = false;
+
+              if (kind_ == kind::string)
+              {
+                e = i + 1;
+                goto done;
+              }
+            }
+          }
+          else
+          {
+            switch (c)
+            {
+            case '"':
+              {
+                string_ = true;
+                break;
+              }
+            case '[':
+            case '{':
+              {
+                ++depth_;
+                break;
+              }
+            case ']':
+            case '}':
+              {
+                if (--depth_ == 0)
+                {
+                  e = i + 1;
+                  goto done;
+                }
+                break;
+              }
+            }
+          }
+        }
+      }
+
+      // Reached the end of the buffer. Return the incomplete value as is at
+      // the end of input.
+      //
+      scan_ = i;
+
+      if (max_size_ != 0 && i - begin_ > max_size_)
+        goto fail_size;
+
+      if (!finished_)
+        return false;
+
+      e = i;
+
+    done:
+      if (max_size_ != 0 && e - begin_ > max_size_)
+        goto fail_size;
+
+      r = make_pair (s + begin_, e - begin_);
+      begin_ = scan_ = e;
+      kind_ = kind::none;
+      return true;
+
+    fail_size:
+      throw invalid_json_input (name_ != nullptr ? name_ : "",
+                                value_line_,
+                                value_column_,
+                                value_position_,
+                                "value size limit exceeded");
+    }
+  }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <string>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <utility> // pair
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Split JSON input text that arrives in chunks (for example, from a
+    // non-blocking socket) into complete top-level JSON values.
+    //
+    // The splitter allows parsing such input without blocking (and without
+    // a thread per input) by accumulating the chunks until the next value
+    // is complete and only then handing it over to a parser (which could,
+    // for example, run on another thread). For example, in a coroutine:
+    //
+    //   value_splitter s;
+    //   for (pair<const char*, size_t> v;; )
+    //   {
+    //     if (s.next (v))
+    //     {
+    //       parser p (v.first, v.second, "<socket>");
+    //       ...
+    //       continue;
+    //     }
+    //
+    //     if (s.finished ())
+    //       break;
+    //
+    //     size_t n (co_await sock.async_read (buf, sizeof (buf)));
+    //
+    //     if (n != 0)
+    //       s.feed (buf, n);
+    //     else
+    //       s.finish ();
+    //   }
+    //
+    // Only the JSON value boundaries are determined (by tracking strings
+    // and the nesting depth), the values themselves are not validated. An
+    // incomplete value at the end of input is returned as is so that the
+    // parser can diagnose it. The memory used is proportional to the size
+    // of the largest value (see incremental_parser for an alternative where
+    // it is proportional to the size of the longest token).
+    //
+    class LIBSTUD_JSON_SYMEXPORT value_splitter
+    {
+    public:
+      // The separators argument has the same semantics as in the parser's
+      // multi-value mode (see parser for details) except that the required
+      // separators are not enforced. If max_size is not 0, then
+      // invalid_json_input is thrown for a value that is larger.
+      //
+      // The name argument is used to identify the input in exceptions. Note
+      // that it and the separators are kept as references so they must
+      // outlive the splitter instance.
+      //
+      explicit
+      value_splitter (const char* name = "",
+                      const char* separators = nullptr,
+                      std::size_t max_size = 0);
+
+      // Append a chunk of input text.
+      //
+      void
+      feed (const void*, std::size_t);
+
+      // Indicate that the end of input has been reached.
+      //
+      void
+      finish ();
+
+      // Return true and the next complete value text if available and false
+      // otherwise, in which case either more input is needed or the end of
+      // input has been reached (see finished()). The returned text is valid
+      // until the next call to any of the non-const functions.
+      //
+      bool
+      next (std::pair<const char*, std::size_t>&);
+
+      // Return true if the end of input has been reached and all the values
+      // have been returned.
+      //
+      bool
+      finished () const {return finished_ && begin_ == buf_.size ();}
+
+      // The line, column (both 1-based), and position (0-based byte offset)
+      // of the beginning of the last value returned in the entire input
+      // text. Can be used to adjust the location in the parser's
+      // exceptions.
+      //
+      std::uint64_t
+      line () const {return value_line_;}
+
+      std::uint64_t
+      column () const {return value_column_;}
+
+      std::uint64_t
+      position () const {return value_position_;}
+
+    private:
+      const char* name_;
+      const char* separators_;
+      std::size_t max_size_;
+
+      // Input text that hasn't yet been returned as values starting from
+      // begin_ and the position in it of the next byte to be scanned.
+      //
+      std::string buf_;
+      std::size_t begin_ = 0;
+      std::size_t scan_ = 0;
+
+      // Position of buf_ in the input text as well as the line and the
+      // position of the line beginning at scan_.
+      //
+      std::uint64_t position_ = 0;
+      std::uint64_t line_ = 1;
+      std::uint64_t line_position_ = 0;
+
+      // Position up to which the columns have been counted and its column
+      // (columns are counted in UTF-8 code points, see advance_column()).
+      //
+      std::uint64_t column_position_ = 0;
+      std::uint64_t column_ = 1;
+
+      void
+      advance_column (std::uint64_t position);
+
+      std::uint64_t value_line_ = 0;
+      std::uint64_t value_column_ = 0;
+      std::uint64_t value_position_ = 0;
+
+      // Scanning state of the current value, if any.
+      //
+      enum class kind {none, structured, string, literal};
+
+      kind kind_ = kind::none;
+      std::size_t depth_ = 0;     // Nesting depth of structured value.
+      bool string_ = false;       // Inside string in structured value.
+      bool escape_ = false;       // After backslash in string.
+
+      bool finished_ = false;
+    };
+  }
+}
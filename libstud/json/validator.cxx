@@ -0,0 +1,675 @@
+#include <libstud/json/validator.hxx>
+
+#include <cmath>     // trunc(), isfinite()
+#include <cstring>   // memchr(), memcmp()
+#include <utility>   // move(), pair
+#include <algorithm> // sort(), lower_bound()
+
+using namespace std;
+
+namespace stud
+{
+  namespace json
+  {
+    [[noreturn]] static void
+    fail (const parser& p, const string& d)
+    {
+      throw invalid_json_input (p.input_name != nullptr ? p.input_name : "",
+                                p.line (),
+                                p.column (),
+                                p.position (),
+                                d);
+    }
+
+    static const char*
+    type_name (event e)
+    {
+      switch (e)
+      {
+      case event::begin_object: return "object";
+      case event::begin_array:  return "array";
+      case event::string:       return "string";
+      case event::number:       return "number";
+      case event::boolean:      return "boolean";
+      case event::null:         return "null";
+      case event::end_object:
+      case event::end_array:
+      case event::name:         break;
+      }
+
+      return "";
+    }
+
+    // Compare the member name with the raw name data.
+    //
+    static int
+    compare (const string& n, const char* s, size_t z)
+    {
+      int r (memcmp (n.c_str (), s, n.size () < z ? n.size () : z));
+      return r != 0 ? r : n.size () < z ? -1 : n.size () > z ? 1 : 0;
+    }
+
+    // Return true if the number (in the JSON representation) is integral.
+    //
+    static bool
+    integral (const parser& p, pair<const char*, size_t> d)
+    {
+      if (memchr (d.first, '.', d.second) == nullptr &&
+          memchr (d.first, 'e', d.second) == nullptr &&
+          memchr (d.first, 'E', d.second) == nullptr)
+        return true;
+
+      double v (p.value<double> ());
+      return isfinite (v) && trunc (v) == v;
+    }
+
+    // Return the number of characters (UTF-8 code points) in the string.
+    //
+    static size_t
+    length (pair<const char*, size_t> d)
+    {
+      size_t r (0);
+      for (const char* s (d.first), *e (s + d.second); s != e; ++s)
+      {
+        if ((static_cast<unsigned char> (*s) & 0xC0) != 0x80)
+          r++;
+      }
+      return r;
+    }
+
+    // schema
+    //
+    schema::
+    schema (parser& p)
+    {
+      init (p);
+    }
+
+    schema::
+    schema (const string& t, const char* n)
+    {
+      parser p (t, n);
+      init (p);
+    }
+
+    void schema::
+    init (parser& p)
+    {
+      nodes_.push_back (node ()); // any
+
+      nodes_.push_back (node ()); // none
+      nodes_.back ().types = 0;
+
+      optional<event> e (p.next ());
+
+      if (!e)
+        fail (p, "invalid schema: schema expected");
+
+      root_ = compile (p, *e);
+    }
+
+    size_t schema::
+    compile (parser& p, event e)
+    {
+      if (e == event::boolean)
+      {
+        if (p.value<bool> ())
+          return any;
+
+        return none;
+      }
+
+      if (e != event::begin_object)
+        fail (p, "invalid schema: object or boolean expected");
+
+      // Note: nodes_ may be reallocated during recursive compilation so we
+      // refer to the node by index.
+      //
+      size_t i (nodes_.size ());
+      nodes_.push_back (node ());
+
+      vector<string> required;
+
+      auto type_bit = [&p] (const string& n) -> unsigned
+      {
+        if (n == "null")    return type_null;
+        if (n == "boolean") return type_boolean;
+        if (n == "object")  return type_object;
+        if (n == "array")   return type_array;
+        if (n == "number")  return type_number;
+        if (n == "integer") return type_integer;
+        if (n == "string")  return type_string;
+
+        fail (p, "invalid schema: unknown type '" + n + '\'');
+      };
+
+      auto parse_literal = [&p] (event e) -> literal
+      {
+        literal r {e, string (), 0};
+
+        switch (e)
+        {
+        case event::string:  r.text = p.value (); break;
+        case event::number:  r.number = p.value<double> (); break;
+        case event::boolean: r.number = p.value<bool> () ? 1 : 0; break;
+        case event::null:    break;
+        case event::begin_object:
+        case event::begin_array:
+          fail (p, "invalid schema: only scalar enum values are supported");
+        case event::end_object:
+        case event::end_array:
+        case event::name:
+          break;
+        }
+
+        return r;
+      };
+
+      while (p.next_expect (event::name, event::end_object))
+      {
+        const string k (p.name ());
+
+        if (k == "type")
+        {
+          unsigned ts (0);
+
+          if (p.next_expect (event::string, event::begin_array))
+            ts = type_bit (p.value ());
+          else
+          {
+            while (p.next_expect (event::string, event::end_array))
+              ts |= type_bit (p.value ());
+          }
+
+          if ((ts & type_number) != 0)
+            ts |= type_integer;
+
+          nodes_[i].types = ts;
+        }
+        else if (k == "enum")
+        {
+          p.next_expect (event::begin_array);
+
+          vector<literal> vs;
+          for (e = *p.next (); e != event::end_array; e = *p.next ())
+            vs.push_back (parse_literal (e));
+
+          nodes_[i].has_enum = true;
+          nodes_[i].enum_values = move (vs);
+        }
+        else if (k == "const")
+        {
+          literal v (parse_literal (*p.next ()));
+
+          nodes_[i].has_enum = true;
+          nodes_[i].enum_values.assign (1, move (v));
+        }
+        else if (k == "minimum")
+        {
+          node& n (nodes_[i]);
+          n.minimum = p.next_expect_number<double> ();
+          n.has_minimum = true;
+        }
+        else if (k == "exclusiveMinimum")
+        {
+          node& n (nodes_[i]);
+          n.exclusive_minimum = p.next_expect_number<double> ();
+          n.has_exclusive_minimum = true;
+        }
+        else if (k == "maximum")
+        {
+          node& n (nodes_[i]);
+          n.maximum = p.next_expect_number<double> ();
+          n.has_maximum = true;
+        }
+        else if (k == "exclusiveMaximum")
+        {
+          node& n (nodes_[i]);
+          n.exclusive_maximum = p.next_expect_number<double> ();
+          n.has_exclusive_maximum = true;
+        }
+        else if (k == "minLength")
+          nodes_[i].min_length = p.next_expect_number<size_t> ();
+        else if (k == "maxLength")
+          nodes_[i].max_length = p.next_expect_number<size_t> ();
+        else if (k == "minItems")
+          nodes_[i].min_items = p.next_expect_number<size_t> ();
+        else if (k == "maxItems")
+          nodes_[i].max_items = p.next_expect_number<size_t> ();
+        else if (k == "minProperties")
+          nodes_[i].min_members = p.next_expect_number<size_t> ();
+        else if (k == "maxProperties")
+          nodes_[i].max_members = p.next_expect_number<size_t> ();
+        else if (k == "items")
+        {
+          e = *p.next ();
+
+          if (e == event::begin_array)
+            fail (p, "invalid schema: only single schema items are supported");
+
+          size_t s (compile (p, e));
+          nodes_[i].items = s;
+        }
+        else if (k == "additionalProperties")
+        {
+          size_t s (compile (p, *p.next ()));
+          nodes_[i].additional = s;
+        }
+        else if (k == "properties")
+        {
+          p.next_expect (event::begin_object);
+
+          while (p.next_expect (event::name, event::end_object))
+          {
+            string n (p.name ());
+
+            for (const member& m: nodes_[i].members)
+            {
+              if (m.name == n)
+                fail (p, "invalid schema: duplicate property '" + n + '\'');
+            }
+
+            size_t s (compile (p, *p.next ()));
+            nodes_[i].members.push_back (
+              member {move (n), s, string::npos});
+          }
+        }
+        else if (k == "required")
+        {
+          p.next_expect (event::begin_array);
+
+          while (p.next_expect (event::string, event::end_array))
+            required.push_back (p.value ());
+        }
+        else if (k == "$schema"     ||
+                 k == "$id"         ||
+                 k == "$comment"    ||
+                 k == "title"       ||
+                 k == "description" ||
+                 k == "default"     ||
+                 k == "examples"    ||
+                 k == "deprecated"  ||
+                 k == "readOnly"    ||
+                 k == "writeOnly"   ||
+                 k == "format")
+          p.next_expect_value_skip ();
+        else
+          fail (p, "invalid schema: unsupported keyword '" + k + '\'');
+      }
+
+      node& n (nodes_[i]);
+
+      // Values of required members that are not listed in properties are
+      // validated against additionalProperties (the schema is resolved
+      // during validation since it may come after required).
+      //
+      for (string& r: required)
+      {
+        member* m (nullptr);
+        for (member& x: n.members)
+        {
+          if (x.name == r)
+          {
+            m = &x;
+            break;
+          }
+        }
+
+        if (m == nullptr)
+        {
+          n.members.push_back (member {move (r), string::npos, string::npos});
+          m = &n.members.back ();
+        }
+
+        if (m->required == string::npos)
+          m->required = n.required++;
+      }
+
+      sort (n.members.begin (), n.members.end (),
+            [] (const member& x, const member& y) {return x.name < y.name;});
+
+      return i;
+    }
+
+    // validator
+    //
+    validator::
+    validator (const schema& s)
+        : schema_ (s)
+    {
+    }
+
+    void validator::
+    next (parser& p, event e)
+    {
+      using node = schema::node;
+      using member = schema::member;
+
+      const vector<node>& ns (schema_.nodes_);
+
+      size_t si; // Schema for the value.
+
+      if (stack_.empty ())
+        si = schema_.root_;
+      else
+      {
+        frame& f (stack_.back ());
+        const node& n (ns[f.node]);
+
+        switch (e)
+        {
+        case event::name:
+          {
+            pair<const char*, size_t> d (p.data ());
+
+            auto i (lower_bound (n.members.begin (), n.members.end (), d,
+                                 [] (const member& m,
+                                     const pair<const char*, size_t>& d)
+                                 {
+                                   return compare (m.name,
+                                                   d.first,
+                                                   d.second) < 0;
+                                 }));
+
+            if (i != n.members.end () &&
+                compare (i->name, d.first, d.second) == 0)
+            {
+              if (i->required != string::npos)
+                seen_[f.seen + i->required] = true;
+            }
+            else
+              i = n.members.end ();
+
+            if (i != n.members.end () && i->schema != string::npos)
+              f.member = i->schema;
+            else if (n.additional == schema::none)
+              fail (p, "unexpected object member '" +
+                    string (d.first, d.second) + '\'');
+            else
+              f.member = n.additional;
+
+            if (++f.count > n.max_members)
+              fail (p, "object has more than " + to_string (n.max_members) +
+                    " members");
+
+            return;
+          }
+        case event::end_object:
+          {
+            if (f.count < n.min_members)
+              fail (p, "object has fewer than " + to_string (n.min_members) +
+                    " members");
+
+            if (n.required != 0)
+            {
+              for (const member& m: n.members)
+              {
+                if (m.required != string::npos && !seen_[f.seen + m.required])
+                  fail (p, "missing required object member '" + m.name + '\'');
+              }
+
+              seen_.resize (f.seen);
+            }
+
+            stack_.pop_back ();
+            return;
+          }
+        case event::end_array:
+          {
+            if (f.count < n.min_items)
+              fail (p, "array has fewer than " + to_string (n.min_items) +
+                    " elements");
+
+            stack_.pop_back ();
+            return;
+          }
+        case event::begin_object:
+        case event::begin_array:
+        case event::string:
+        case event::number:
+        case event::boolean:
+        case event::null:
+          break;
+        }
+
+        if (f.array)
+        {
+          if (++f.count > n.max_items)
+            fail (p, "array has more than " + to_string (n.max_items) +
+                  " elements");
+
+          si = n.items;
+        }
+        else
+          si = f.member;
+      }
+
+      if (si == schema::any)
+      {
+        // Still have to track the structure to know where the value ends.
+        //
+        if (e == event::begin_object || e == event::begin_array)
+          stack_.push_back (
+            frame {si, e == event::begin_array, 0, schema::any, 0});
+
+        return;
+      }
+
+      const node& n (ns[si]);
+
+      // Type.
+      //
+      unsigned t (0);
+      switch (e)
+      {
+      case event::begin_object: t = schema::type_object;  break;
+      case event::begin_array:  t = schema::type_array;   break;
+      case event::string:       t = schema::type_string;  break;
+      case event::boolean:      t = schema::type_boolean; break;
+      case event::null:         t = schema::type_null;    break;
+      case event::number:
+        {
+          t = (n.types & schema::type_number) == 0 &&
+              (n.types & schema::type_integer) != 0 &&
+              integral (p, p.data ())
+            ? schema::type_integer
+            : schema::type_number;
+          break;
+        }
+      case event::end_object:
+      case event::end_array:
+      case event::name:
+        break;
+      }
+
+      if ((n.types & t) == 0)
+      {
+        if (n.types == 0)
+          fail (p, string ("unexpected ") + type_name (e) + " value");
+
+        string d ("expected ");
+        static const char* names[] = {
+          "null", "boolean", "object", "array", "number", "integer", "string"};
+
+        bool first (true);
+        for (unsigned b (0); b != 7; ++b)
+        {
+          unsigned m (1U << b);
+
+          if ((n.types & m) == 0 ||
+              (m == schema::type_integer &&
+               (n.types & schema::type_number) != 0))
+            continue;
+
+          if (!first)
+            d += " or ";
+
+          d += names[b];
+          first = false;
+        }
+
+        d += " instead of ";
+        d += type_name (e);
+
+        fail (p, d);
+      }
+
+      // Enum (and const).
+      //
+      if (n.has_enum)
+      {
+        bool r (false);
+
+        for (const schema::literal& l: n.enum_values)
+        {
+          if (l.type != e)
+            continue;
+
+          switch (e)
+          {
+          case event::string:
+            {
+              pair<const char*, size_t> d (p.data ());
+              r = compare (l.text, d.first, d.second) == 0;
+              break;
+            }
+          case event::number:
+            {
+              r = l.number == p.value<double> ();
+              break;
+            }
+          case event::boolean:
+            {
+              r = l.number == (p.value<bool> () ? 1 : 0);
+              break;
+            }
+          case event::null:
+            {
+              r = true;
+              break;
+            }
+          case event::begin_object:
+          case event::begin_array:
+          case event::end_object:
+          case event::end_array:
+          case event::name:
+            break;
+          }
+
+          if (r)
+            break;
+        }
+
+        if (!r)
+          fail (p, string (type_name (e)) + " value is not one of the "
+                "enumerated values");
+      }
+
+      switch (e)
+      {
+      case event::begin_object:
+        {
+          stack_.push_back (
+            frame {si, false, 0, schema::any, seen_.size ()});
+
+          if (n.required != 0)
+            seen_.resize (seen_.size () + n.required, false);
+
+          break;
+        }
+      case event::begin_array:
+        {
+          stack_.push_back (frame {si, true, 0, schema::any, 0});
+          break;
+        }
+      case event::string:
+        {
+          if (n.min_length != 0 || n.max_length != string::npos)
+          {
+            size_t l (length (p.data ()));
+
+            if (l < n.min_length)
+              fail (p, "string is shorter than " + to_string (n.min_length) +
+                    " characters");
+
+            if (l > n.max_length)
+              fail (p, "string is longer than " + to_string (n.max_length) +
+                    " characters");
+          }
+
+          break;
+        }
+      case event::number:
+        {
+          if (n.has_minimum || n.has_exclusive_minimum ||
+              n.has_maximum || n.has_exclusive_maximum)
+          {
+            double v (p.value<double> ());
+
+            // Note that both the inclusive and exclusive bounds may be
+            // specified in which case both apply.
+            //
+            auto fail_number = [&p] (const char* what)
+            {
+              pair<const char*, size_t> d (p.data ());
+              fail (p, "number " + string (d.first, d.second) + ' ' + what);
+            };
+
+            if (n.has_minimum && v < n.minimum)
+              fail_number ("is less than minimum");
+
+            if (n.has_exclusive_minimum && v <= n.exclusive_minimum)
+              fail_number ("is less than or equal to minimum");
+
+            if (n.has_maximum && v > n.maximum)
+              fail_number ("is greater than maximum");
+
+            if (n.has_exclusive_maximum && v >= n.exclusive_maximum)
+              fail_number ("is greater than or equal to maximum");
+          }
+
+          break;
+        }
+      case event::boolean:
+      case event::null:
+      case event::end_object:
+      case event::end_array:
+      case event::name:
+        break;
+      }
+    }
+
+    void validator::
+    validate (parser& p, event e)
+    {
+      size_t d (stack_.size ());
+
+      for (;;)
+      {
+        next (p, e);
+
+        if (stack_.size () == d)
+          break;
+
+        e = *p.next ();
+      }
+    }
+
+    size_t validator::
+    validate (parser& p)
+    {
+      size_t r (0);
+
+      while (p.peek ())
+      {
+        while (optional<event> e = p.next ())
+        {
+          validate (p, *e);
+          r++;
+        }
+      }
+
+      return r;
+    }
+  }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef> // size_t
+
+#include <libstud/json/event.hxx>
+#include <libstud/json/parser.hxx>
+
+#include <libstud/json/export.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Streaming validation against a JSON Schema.
+    //
+    // The schema is compiled into a table of nodes, one per subschema, which
+    // is then used to validate the parser events as they are produced,
+    // without building any representation of the value being validated.
+    // The following subset of JSON Schema keywords is supported:
+    //
+    // type (including integer), enum and const (scalar values only),
+    // minimum, maximum, exclusiveMinimum, exclusiveMaximum (numbers only),
+    // minLength, maxLength, items (single schema only), minItems, maxItems,
+    // properties, required, additionalProperties, minProperties, and
+    // maxProperties.
+    //
+    // Boolean schemas (true and false) are supported. The annotation
+    // keywords ($schema, $id, $comment, title, description, default,
+    // examples, deprecated, readOnly, writeOnly, and format) are ignored.
+    // Any other keyword (for example, pattern or $ref) is rejected rather
+    // than being silently ignored.
+    //
+    // For example:
+    //
+    //   const schema sc (schema_text, "schema.json");
+    //
+    //   parser p (cin, "<stdin>");
+    //   validator v (sc);
+    //   while (optional<event> e = p.next ())
+    //   {
+    //     v.next (p, *e); // Throws on the first violation.
+    //     ...
+    //   }
+    //
+    class LIBSTUD_JSON_SYMEXPORT schema
+    {
+    public:
+      // Compile the schema from the JSON value that is next in the parser.
+      // Throw invalid_json_input if the schema is invalid or uses an
+      // unsupported keyword.
+      //
+      explicit
+      schema (parser&);
+
+      explicit
+      schema (const std::string& text, const char* name = "<schema>");
+
+    private:
+      friend class validator;
+
+      // Value type bits.
+      //
+      static const unsigned type_null    = 0x01;
+      static const unsigned type_boolean = 0x02;
+      static const unsigned type_object  = 0x04;
+      static const unsigned type_array   = 0x08;
+      static const unsigned type_number  = 0x10;
+      static const unsigned type_integer = 0x20;
+      static const unsigned type_string  = 0x40;
+      static const unsigned type_any     = 0x7f;
+
+      // Indexes of the true (matches anything) and false (matches nothing)
+      // schema nodes.
+      //
+      static const std::size_t any  = 0;
+      static const std::size_t none = 1;
+
+      struct member
+      {
+        std::string name;
+        std::size_t schema;   // Schema or npos if not in properties.
+        std::size_t required; // Index among required or npos.
+      };
+
+      struct literal
+      {
+        event type;
+        std::string text; // String value.
+        double number;    // Number value.
+      };
+
+      struct node
+      {
+        unsigned types = type_any;
+
+        double minimum = 0, maximum = 0;
+        bool has_minimum = false, has_maximum = false;
+
+        double exclusive_minimum = 0, exclusive_maximum = 0;
+        bool has_exclusive_minimum = false, has_exclusive_maximum = false;
+
+        std::size_t min_length = 0, max_length = std::string::npos;
+        std::size_t min_items = 0, max_items = std::string::npos;
+        std::size_t min_members = 0, max_members = std::string::npos;
+
+        std::size_t items = any;
+        std::size_t additional = any;
+
+        std::vector<member> members; // Sorted by name.
+        std::size_t required = 0;    // Number of required members.
+
+        bool has_enum = false;
+        std::vector<literal> enum_values;
+      };
+
+      void
+      init (parser&);
+
+      std::size_t
+      compile (parser&, event);
+
+      std::vector<node> nodes_;
+      std::size_t root_;
+    };
+
+    class LIBSTUD_JSON_SYMEXPORT validator
+    {
+    public:
+      // Note that the schema is kept as a reference and so must outlive the
+      // validator instance.
+      //
+      explicit
+      validator (const schema&);
+
+      // Validate the event that has just been returned by the parser's
+      // next() function. This function should be called for every event,
+      // in order, and before calling peek(). Throw invalid_json_input with
+      // the location of the offending event on the first violation, after
+      // which the validator should be reset() before being reused.
+      //
+      // Once a top-level value has been validated, the validator is ready
+      // for the next value (for example, in the multi-value mode).
+      //
+      void
+      next (parser&, event);
+
+      // Validate the JSON value whose first event has just been returned by
+      // the parser's next() function (similar to copy_value()).
+      //
+      void
+      validate (parser&, event first);
+
+      // Validate all the JSON values returning the number of values
+      // validated (similar to reformat()).
+      //
+      std::size_t
+      validate (parser&);
+
+      // Return true if no value is partially validated.
+      //
+      bool
+      complete () const {return stack_.empty ();}
+
+      void
+      reset () {stack_.clear (); seen_.clear ();}
+
+    private:
+      struct frame
+      {
+        std::size_t node;
+        bool array;
+        std::size_t count;  // Number of elements or members so far.
+        std::size_t member; // Schema for the current member value.
+        std::size_t seen;   // Offset of the required members seen flags.
+      };
+
+      const schema& schema_;
+      std::vector<frame> stack_;
+      std::vector<bool> seen_;
+    };
+  }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <ostream>
+#include <cstddef> // size_t
+
+#include <zlib.h>
+
+#include <libstud/optional.hxx> // stud::optional is std::optional or similar.
+
+#include <libstud/json/compressing-serializer.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Serialize to std::ostream compressing the output text with zlib as it
+    // is being serialized.
+    //
+    // Note that this serializer is header-only and is not used by the
+    // library itself. As a result, the user of this header is responsible
+    // for linking zlib.
+    //
+    class zlib_serializer: public compressing_serializer<zlib_serializer>
+    {
+    public:
+      // Input/output as well as compression errors are reported as the
+      // invalid_json_output exception.
+      //
+      // The level argument specifies the zlib compression level and if gzip
+      // is true, then the gzip format is produced instead of zlib.
+      //
+      // If sync_flush is true, then after each complete JSON value the
+      // compressed stream is flushed (Z_SYNC_FLUSH) and so is the output
+      // stream. This makes each value boundary (for example, an NDJSON
+      // record) a point up to which the output can be decompressed at the
+      // expense of a somewhat lower compression ratio.
+      //
+      // Note that finish() must be called after the last value to complete
+      // the compressed stream.
+      //
+      explicit
+      zlib_serializer (std::ostream&,
+                       std::size_t indentation = 2,
+                       const char* multi_value_separator = "\n",
+                       int level = Z_DEFAULT_COMPRESSION,
+                       bool gzip = true,
+                       bool sync_flush = false);
+
+      ~zlib_serializer ();
+
+    private:
+      friend class compressing_serializer<zlib_serializer>;
+
+      void
+      compress (optional<event>, const void*, std::size_t, compress_mode);
+
+      z_stream zs_;
+    };
+
+    inline zlib_serializer::
+    zlib_serializer (std::ostream& os,
+                     std::size_t i, const char* mvs,
+                     int l, bool gz, bool sf)
+        : compressing_serializer (os, i, mvs, sf)
+    {
+      zs_.zalloc = Z_NULL;
+      zs_.zfree = Z_NULL;
+      zs_.opaque = Z_NULL;
+
+      // Adding 16 to the window bits selects the gzip format.
+      //
+      if (deflateInit2 (&zs_,
+                        l,
+                        Z_DEFLATED,
+                        gz ? 15 + 16 : 15,
+                        8 /* memLevel */,
+                        Z_DEFAULT_STRATEGY) != Z_OK)
+        fail (nullopt, "unable to initialize zlib compression");
+    }
+
+    inline zlib_serializer::
+    ~zlib_serializer ()
+    {
+      deflateEnd (&zs_);
+    }
+
+    inline void zlib_serializer::
+    compress (optional<event> e, const void* d, std::size_t n, compress_mode m)
+    {
+      // Note that n never exceeds the size of our buffer and so fits uInt.
+      //
+      zs_.next_in = static_cast<Bytef*> (const_cast<void*> (d));
+      zs_.avail_in = static_cast<uInt> (n);
+
+      int f (m == compress_mode::none  ? Z_NO_FLUSH   :
+             m == compress_mode::flush ? Z_SYNC_FLUSH :
+             Z_FINISH);
+
+      // Keep calling deflate() while it fills the entire output buffer.
+      //
+      do
+      {
+        zs_.next_out = reinterpret_cast<Bytef*> (out_);
+        zs_.avail_out = sizeof (out_);
+
+        if (deflate (&zs_, f) == Z_STREAM_ERROR)
+          fail (e, "unable to compress JSON output text");
+
+        output (e, out_, sizeof (out_) - zs_.avail_out);
+      }
+      while (zs_.avail_out == 0);
+    }
+  }
+}
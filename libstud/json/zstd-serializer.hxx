@@ -0,0 +1,109 @@
+#pragma once
+
+#include <ostream>
+#include <cstddef> // size_t
+
+#include <zstd.h>
+
+#include <libstud/optional.hxx> // stud::optional is std::optional or similar.
+
+#include <libstud/json/compressing-serializer.hxx>
+
+namespace stud
+{
+  namespace json
+  {
+    // Serialize to std::ostream compressing the output text with zstd as it
+    // is being serialized.
+    //
+    // Note that this serializer is header-only and is not used by the
+    // library itself. As a result, the user of this header is responsible
+    // for linking libzstd.
+    //
+    class zstd_serializer: public compressing_serializer<zstd_serializer>
+    {
+    public:
+      // Input/output as well as compression errors are reported as the
+      // invalid_json_output exception.
+      //
+      // The level argument specifies the zstd compression level with 0
+      // meaning the zstd default.
+      //
+      // If sync_flush is true, then after each complete JSON value the
+      // compressed stream is flushed (ZSTD_e_flush) and so is the output
+      // stream. This makes each value boundary (for example, an NDJSON
+      // record) a point up to which the output can be decompressed at the
+      // expense of a somewhat lower compression ratio.
+      //
+      // Note that finish() must be called after the last value to complete
+      // the compressed stream.
+      //
+      explicit
+      zstd_serializer (std::ostream&,
+                       std::size_t indentation = 2,
+                       const char* multi_value_separator = "\n",
+                       int level = 0,
+                       bool sync_flush = false);
+
+      ~zstd_serializer ();
+
+    private:
+      friend class compressing_serializer<zstd_serializer>;
+
+      void
+      compress (optional<event>, const void*, std::size_t, compress_mode);
+
+      ZSTD_CCtx* cctx_;
+    };
+
+    inline zstd_serializer::
+    zstd_serializer (std::ostream& os,
+                     std::size_t i, const char* mvs,
+                     int l, bool sf)
+        : compressing_serializer (os, i, mvs, sf),
+          cctx_ (ZSTD_createCCtx ())
+    {
+      if (cctx_ == nullptr ||
+          ZSTD_isError (
+            ZSTD_CCtx_setParameter (cctx_, ZSTD_c_compressionLevel, l)))
+      {
+        ZSTD_freeCCtx (cctx_); // Can be NULL.
+        fail (nullopt, "unable to initialize zstd compression");
+      }
+    }
+
+    inline zstd_serializer::
+    ~zstd_serializer ()
+    {
+      ZSTD_freeCCtx (cctx_);
+    }
+
+    inline void zstd_serializer::
+    compress (optional<event> e, const void* d, std::size_t n, compress_mode m)
+    {
+      ZSTD_EndDirective z (m == compress_mode::none  ? ZSTD_e_continue :
+                           m == compress_mode::flush ? ZSTD_e_flush    :
+                           ZSTD_e_end);
+
+      ZSTD_inBuffer in {d, n, 0};
+
+      // Keep calling ZSTD_compressStream2() until the input is consumed or,
+      // when flushing or ending, until the flush is complete.
+      //
+      for (;;)
+      {
+        ZSTD_outBuffer out {out_, sizeof (out_), 0};
+
+        std::size_t r (ZSTD_compressStream2 (cctx_, &out, &in, z));
+
+        if (ZSTD_isError (r))
+          fail (e, "unable to compress JSON output text");
+
+        output (e, out_, out.pos);
+
+        if (z == ZSTD_e_continue ? in.pos == in.size : r == 0)
+          break;
+      }
+    }
+  }
+}
@@ -0,0 +1,359 @@
+// Verify that, once warmed up, parsing and serialization do not allocate
+// any memory.
+//
+// We count calls to the replaceable global operator new and, with glibc,
+// also to malloc() and friends (used by pdjson). Allocation counting is only
+// enabled for the duration of each measured step (an event or a complete
+// value) so that the test harness itself can allocate freely.
+
+#include <new>       // bad_alloc
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdio>    // tmpfile(), fileno()
+#include <cstddef>   // size_t
+#include <cstdint>   // int64_t
+#include <cstdlib>   // malloc(), free()
+#include <sstream>
+#include <ostream>
+#include <streambuf>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/serializer.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+static bool counting;
+static size_t allocations;
+
+void*
+operator new (size_t n)
+{
+  if (counting)
+    allocations++;
+
+  if (void* p = malloc (n != 0 ? n : 1))
+    return p;
+
+  throw bad_alloc ();
+}
+
+void
+operator delete (void* p) noexcept
+{
+  free (p);
+}
+
+void
+operator delete (void* p, size_t) noexcept
+{
+  free (p);
+}
+
+#ifdef __GLIBC__
+extern "C"
+{
+  void* __libc_malloc (size_t);
+  void* __libc_calloc (size_t, size_t);
+  void* __libc_realloc (void*, size_t);
+
+  void*
+  malloc (size_t n)
+  {
+    if (counting)
+      allocations++;
+
+    return __libc_malloc (n);
+  }
+
+  void*
+  calloc (size_t n, size_t s)
+  {
+    if (counting)
+      allocations++;
+
+    return __libc_calloc (n, s);
+  }
+
+  void*
+  realloc (void* p, size_t n)
+  {
+    if (counting)
+      allocations++;
+
+    return __libc_realloc (p, n);
+  }
+}
+#endif
+
+// Return the number of allocations performed by the function.
+//
+template <typename F>
+static size_t
+count (const F& f)
+{
+  allocations = 0;
+  counting = true;
+  f ();
+  counting = false;
+  return allocations;
+}
+
+// Output stream buffer that discards everything.
+//
+struct null_buf: streambuf
+{
+  virtual int_type
+  overflow (int_type c) override {return c;}
+
+  virtual streamsize
+  xsputn (const char*, streamsize n) override {return n;}
+};
+
+// Number of records in the input (the first one is used for warm-up).
+//
+static const size_t records (100);
+
+static string
+input ()
+{
+  string r;
+  for (size_t i (0); i != records; ++i)
+  {
+    r += "{\"id\": ";
+    r += to_string (100000 + i);
+    r += ", \"name\": \"record\", \"score\": 1.5, \"esc\": \"a\\\"b\\u00e9\", "
+         "\"tags\": [\"a\", \"b\"], "
+         "\"nested\": {\"flags\": [true, false, null], \"x\": {}}}\n";
+  }
+  return r;
+}
+
+// Parse all the records, once warmed up verifying that every event is
+// parsed and accessed without allocating.
+//
+static void
+parse (parser& p, bool peek)
+{
+  auto step = [&p, peek] () -> optional<event>
+  {
+    if (peek)
+      p.peek ();
+
+    optional<event> e (p.next ());
+
+    if (e)
+    {
+      switch (*e)
+      {
+      case event::name:    p.name ();  break;
+      case event::string:  p.value (); break;
+      case event::number:
+        {
+          if (p.value ().find ('.') != string::npos)
+            p.value<double> ();
+          else
+            p.value<int64_t> ();
+          break;
+        }
+      case event::boolean: p.value<bool> (); break;
+      default:                               break;
+      }
+    }
+
+    return e;
+  };
+
+  for (size_t i (0); ; ++i)
+  {
+    const bool warm (i != 0);
+    size_t n (0); // Per record.
+
+    bool more;
+    n += count ([&p, &more] () {more = p.peek ().has_value ();});
+
+    if (!more)
+      break;
+
+    for (optional<event> e;; )
+    {
+      size_t a (count ([&step, &e] () {e = step ();}));
+      assert (!warm || a == 0); // Per event.
+      n += a;
+
+      if (!e)
+        break;
+    }
+
+    assert (!warm || n == 0);
+  }
+}
+
+// Serialize a record with the serializer.
+//
+static void
+serialize (buffer_serializer& s, size_t i)
+{
+  s.begin_object ();
+  s.member ("id", 100000 + i);
+  s.member ("name", "record");
+  s.member ("score", 1.5);
+  s.member ("esc", "a\"b\xC3\xA9");
+  s.member_begin_array ("tags");
+  s.value ("a");
+  s.value ("b");
+  s.end_array ();
+  s.member_begin_object ("nested");
+  s.member_begin_array ("flags");
+  s.value (true);
+  s.value (false);
+  s.value (nullptr);
+  s.end_array ();
+  s.member_begin_object ("x");
+  s.end_object ();
+  s.end_object ();
+  s.end_object ();
+}
+
+// Serialize all the records, once warmed up verifying that each record is
+// serialized without allocating.
+//
+static void
+serialize (buffer_serializer& s)
+{
+  for (size_t i (0); i != records; ++i)
+  {
+    size_t a (count ([&s, i] () {serialize (s, i);}));
+    assert (i == 0 || a == 0);
+  }
+}
+
+int
+main ()
+{
+  // Make sure allocation counting works.
+  //
+  {
+    static void* volatile p;
+    size_t a (count ([] () {p = new int (1);}));
+    assert (a != 0);
+    delete static_cast<int*> (p);
+
+#ifdef __GLIBC__
+    a = count ([] () {p = malloc (1);});
+    assert (a != 0);
+    free (p);
+#endif
+  }
+
+  const string in (input ());
+
+  // Parser.
+  //
+  for (bool peek: {false, true})
+  {
+    {
+      parser p (in, "<buffer>", true /* multi_value */, "\n");
+      parse (p, peek);
+    }
+
+    {
+      istringstream is (in);
+      parser p (is, "<stream>", true /* multi_value */, "\n");
+      parse (p, peek);
+    }
+  }
+
+  // Serializer.
+  //
+  for (size_t ind: {0, 2})
+  {
+    // String and vector (with space reserved).
+    //
+    {
+      string b;
+      b.reserve (records * 1024);
+      buffer_serializer s (b, ind);
+      serialize (s);
+    }
+
+    {
+      vector<char> b;
+      b.reserve (records * 1024);
+      buffer_serializer s (b, ind);
+      serialize (s);
+    }
+
+    // Fixed array.
+    //
+    {
+      static array<char, 256 * 1024> b;
+      size_t n (0);
+      buffer_serializer s (b, n, ind);
+      serialize (s);
+    }
+
+    // Block buffer (the records fit into the first block).
+    //
+    {
+      block_buffer b (records * 1024);
+      buffer_serializer s (b, ind);
+      serialize (s);
+    }
+
+    // Block buffer with records spanning many blocks, reused (for example,
+    // for each response) after clear(). Once allocated, the blocks should
+    // be recycled without allocating (note that the first record warms up
+    // the new serializer).
+    //
+    {
+      block_buffer b (256);
+      {
+        buffer_serializer s (b, ind);
+        for (size_t i (0); i != records; ++i)
+          serialize (s, i);
+      }
+
+      const size_t n (b.blocks ().size ());
+      assert (n > 10);
+
+      for (size_t i (0); i != 3; ++i)
+      {
+        b.clear ();
+        {
+          buffer_serializer s (b, ind);
+          serialize (s);
+        }
+        assert (b.blocks ().size () == n);
+      }
+    }
+
+    // Stream.
+    //
+    {
+      null_buf nb;
+      ostream os (&nb);
+      stream_serializer s (os, ind);
+      serialize (s);
+    }
+
+#ifndef _WIN32
+    // File descriptor.
+    //
+    {
+      FILE* f (tmpfile ());
+      assert (f != nullptr);
+      {
+        fd_serializer s (fileno (f), ind);
+        serialize (s);
+      }
+      fclose (f);
+    }
+#endif
+  }
+}
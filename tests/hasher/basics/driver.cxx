@@ -0,0 +1,116 @@
+#include <string>
+#include <vector>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/hasher.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Return the hashes of all the values in the input.
+//
+static vector<hasher::digest>
+hash_all (const string& in, bool unordered = false, uint64_t seed = 0)
+{
+  vector<hasher::digest> r;
+
+  parser p (in, "test", true /* multi_value */);
+  hasher h (unordered, seed);
+
+  while (p.peek ())
+  {
+    while (stud::optional<event> e = p.next ())
+    {
+      if (h.next (p, *e))
+        r.push_back (h.result ());
+    }
+  }
+
+  return r;
+}
+
+static hasher::digest
+digest_of (const string& in, bool unordered = false)
+{
+  vector<hasher::digest> r (hash_all (in, unordered));
+  assert (r.size () == 1);
+  return r.front ();
+}
+
+int
+main ()
+{
+  // Whitespace and escape sequences.
+  //
+  assert (digest_of ("{\"a\":\"xA\",\"b\":[1,2,true,null]}") ==
+          digest_of ("{ \"\\u0061\" : \"x\\u0041\" ,\n"
+                "  \"b\" : [ 1 , 2 , true , null ] }"));
+
+  assert (digest_of ("\"\\/\\n\"") == digest_of ("\"/\\u000a\""));
+
+  // Different values.
+  //
+  assert (digest_of ("1") != digest_of ("\"1\""));
+  assert (digest_of ("1") != digest_of ("1.0"));
+  assert (digest_of ("[]") != digest_of ("{}"));
+  assert (digest_of ("true") != digest_of ("false"));
+  assert (digest_of ("null") != digest_of ("[null]"));
+  assert (digest_of ("[\"ab\",\"c\"]") != digest_of ("[\"a\",\"bc\"]"));
+  assert (digest_of ("{\"a\":\"b\"}") != digest_of ("[\"a\",\"b\"]"));
+  assert (digest_of ("[[1],2]") != digest_of ("[[1,2]]"));
+
+  // Member order.
+  //
+  {
+    const string x ("{\"a\":1,\"b\":{\"c\":[1,2],\"d\":null}}");
+    const string y ("{\"b\":{\"d\":null,\"c\":[1,2]},\"a\":1}");
+
+    assert (digest_of (x) != digest_of (y));
+    assert (digest_of (x, true) == digest_of (y, true));
+    assert (digest_of (x) != digest_of (x, true));
+
+    // Array element order still matters.
+    //
+    assert (digest_of ("{\"a\":[1,2]}", true) != digest_of ("{\"a\":[2,1]}", true));
+
+    // Members are not mixed up between objects.
+    //
+    assert (digest_of ("{\"a\":{\"b\":1}}", true) !=
+            digest_of ("{\"a\":{},\"b\":1}", true));
+    assert (digest_of ("[{\"a\":1},{\"b\":2}]", true) !=
+            digest_of ("[{\"a\":1,\"b\":2}]", true));
+    assert (digest_of ("{\"a\":1,\"b\":2}", true) !=
+            digest_of ("{\"a\":2,\"b\":1}", true));
+    assert (digest_of ("{}", true) != digest_of ("[]", true));
+  }
+
+  // Multiple values.
+  //
+  {
+    vector<hasher::digest> r (hash_all ("1 {\"a\":[1]} \"x\"\n{\"a\":[ 1 ]}"));
+    assert (r.size () == 4);
+    assert (r[0] == digest_of ("1"));
+    assert (r[1] == r[3]);
+    assert (r[1] != r[2]);
+  }
+
+  // Seed.
+  //
+  assert (hash_all ("[1]", false, 1)[0] != hash_all ("[1]", false, 2)[0]);
+  assert (hash_all ("[1]", false, 0)[0] == digest_of ("[1]"));
+
+  // Value-at-a-time interface.
+  //
+  {
+    parser p ("{\"a\":1} [2]", "test", true);
+    hasher h;
+
+    assert (h.hash (p, *p.next ()) == digest_of ("{\"a\":1}"));
+    assert (p.next () == stud::nullopt);
+    assert (h.hash (p, *p.next ()) == digest_of ("[2]"));
+  }
+}
@@ -0,0 +1,164 @@
+#include <string>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/serializer.hxx>
+#include <libstud/json/merge-patch.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Apply the patch to all the values in the target returning the result
+// serialized without indentation.
+//
+static string
+merge (const string& target, const string& patch)
+{
+  string r;
+  {
+    merge_patch mp (patch);
+    parser p (target, "target", true /* multi_value */, " ");
+    buffer_serializer s (r, 0, " ");
+    mp.apply (p, s);
+  }
+  return r;
+}
+
+int
+main ()
+{
+  // Test cases from RFC 7386 Appendix A.
+  //
+  assert (merge ("{\"a\":\"b\"}", "{\"a\":\"c\"}") == "{\"a\":\"c\"}");
+  assert (merge ("{\"a\":\"b\"}", "{\"b\":\"c\"}") == "{\"a\":\"b\",\"b\":\"c\"}");
+  assert (merge ("{\"a\":\"b\"}", "{\"a\":null}") == "{}");
+  assert (merge ("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}") ==
+          "{\"b\":\"c\"}");
+  assert (merge ("{\"a\":[\"b\"]}", "{\"a\":\"c\"}") == "{\"a\":\"c\"}");
+  assert (merge ("{\"a\":\"c\"}", "{\"a\":[\"b\"]}") == "{\"a\":[\"b\"]}");
+  assert (merge ("{\"a\":{\"b\":\"c\"}}",
+                 "{\"a\":{\"b\":\"d\",\"c\":null}}") ==
+          "{\"a\":{\"b\":\"d\"}}");
+  assert (merge ("{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}") ==
+          "{\"a\":[1]}");
+  assert (merge ("[\"a\",\"b\"]", "[\"c\",\"d\"]") == "[\"c\",\"d\"]");
+  assert (merge ("{\"a\":\"b\"}", "[\"c\"]") == "[\"c\"]");
+  assert (merge ("{\"a\":\"foo\"}", "null") == "null");
+  assert (merge ("{\"a\":\"foo\"}", "\"bar\"") == "\"bar\"");
+  assert (merge ("{\"e\":null}", "{\"a\":1}") == "{\"e\":null,\"a\":1}");
+  assert (merge ("[1,2]", "{\"a\":\"b\",\"c\":null}") == "{\"a\":\"b\"}");
+  assert (merge ("{}", "{\"a\":{\"bb\":{\"ccc\":null}}}") ==
+          "{\"a\":{\"bb\":{}}}");
+
+  // Duplicate patch members are rejected.
+  //
+  for (const char* p: {"{\"a\":2,\"a\":3}",
+                       "{\"x\":{\"b\":1,\"a\":null,\"b\":null}}"})
+  {
+    try
+    {
+      merge_patch mp (p);
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (string (e.what ()).find ("duplicate patch object member") == 0);
+    }
+  }
+
+  // Many patch members, in and out of the target, applied in the target
+  // order with the new ones appended in the patch order.
+  //
+  {
+    string t ("{"), p ("{"), r ("{");
+    for (size_t i (0); i != 100; ++i)
+    {
+      const string n ("\"m" + to_string ((i * 37) % 100) + '"');
+
+      if (i != 0)
+      {
+        t += ',';
+        p += ',';
+      }
+
+      t += n + ":0";
+      p += n + (i % 3 == 0 ? ":null" : ":1");
+      r += i % 3 == 0 ? "" : (r.size () != 1 ? "," : "") + n + ":1";
+
+      p += ",\"n" + to_string (i) + "\":2";
+    }
+
+    // New members.
+    //
+    for (size_t i (0); i != 100; ++i)
+      r += ",\"n" + to_string (i) + "\":2";
+
+    t += '}';
+    p += '}';
+    r += '}';
+
+    assert (merge (t, p) == r);
+  }
+
+  // Untouched members are copied as is, including nested values.
+  //
+  assert (merge ("{\"x\":{\"y\":[1,{\"z\":null}]},\"a\":1,\"b\":true}",
+                 "{\"a\":2}") ==
+          "{\"x\":{\"y\":[1,{\"z\":null}]},\"a\":2,\"b\":true}");
+
+  // Member names with escapes.
+  //
+  assert (merge ("{\"a\\u0022b\":1,\"c\":2}", "{\"a\\\"b\":null}") ==
+          "{\"c\":2}");
+
+  // Nulls in patch arrays are preserved.
+  //
+  assert (merge ("{}", "{\"a\":[null,{\"b\":null}]}") ==
+          "{\"a\":[null,{\"b\":null}]}");
+
+  // Multiple values.
+  //
+  assert (merge ("{\"a\":1} {\"b\":2} 3", "{\"a\":null,\"c\":3}") ==
+          "{\"c\":3} {\"b\":2,\"c\":3} {\"c\":3}");
+
+  // Patch values that need escaping are serialized (every time) as parsed.
+  //
+  assert (merge ("{} []",
+                 "{\"a\":[\"x\\ny\",\"\\u0041\\\"\",\"\"],"
+                 "\"b\\\\\":{\"c\\t\":-1.5e3}}") ==
+          "{\"a\":[\"x\\ny\",\"A\\\"\",\"\"],\"b\\\\\":{\"c\\t\":-1.5e3}} "
+          "{\"a\":[\"x\\ny\",\"A\\\"\",\"\"],\"b\\\\\":{\"c\\t\":-1.5e3}}");
+
+  // Nested patch objects applied to multiple values with the members found
+  // in some targets but not others.
+  //
+  assert (merge ("{\"a\":{\"x\":0}} {\"a\":{\"y\":0}} {\"b\":1} {\"a\":{}}",
+                 "{\"a\":{\"x\":1,\"y\":null}}") ==
+          "{\"a\":{\"x\":1}} {\"a\":{\"x\":1}} {\"b\":1,\"a\":{\"x\":1}} "
+          "{\"a\":{\"x\":1}}");
+
+  // Pretty-printing.
+  //
+  {
+    string r;
+    {
+      merge_patch mp ("{\"b\":{\"c\":[1,2]}}");
+      parser p ("{\"a\":1}", "target");
+      buffer_serializer s (r);
+      mp.apply (p, s, *p.next ());
+    }
+
+    assert (r == "{\n"
+                 "  \"a\": 1,\n"
+                 "  \"b\": {\n"
+                 "    \"c\": [\n"
+                 "      1,\n"
+                 "      2\n"
+                 "    ]\n"
+                 "  }\n"
+                 "}");
+  }
+}
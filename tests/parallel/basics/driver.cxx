@@ -0,0 +1,299 @@
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/parallel.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Serialize the element's events and values into a string.
+//
+static string
+element (parser& p)
+{
+  string r;
+  size_t d (0);
+  do
+  {
+    event e (*p.next ());
+    r += to_string (static_cast<int> (e));
+
+    switch (e)
+    {
+    case event::begin_object:
+    case event::begin_array: ++d; break;
+    case event::end_object:
+    case event::end_array:   --d; break;
+    case event::name:        r += p.name (); break;
+    default:                 r += p.value (); break;
+    }
+    r += ' ';
+  }
+  while (d != 0);
+
+  return r;
+}
+
+// Parse the array sequentially.
+//
+static vector<string>
+parse (const string& s)
+{
+  vector<string> r;
+  parser p (s, "test");
+  p.next_expect (event::begin_array);
+  while (p.peek () != event::end_array)
+    r.push_back (element (p));
+  p.next_expect (event::end_array);
+  assert (!p.next ());
+  return r;
+}
+
+// How much of each element the function consumes.
+//
+enum class consume
+{
+  element, // All the events of the element (but not the absent event).
+  drain,   // All the events of the element including the absent event.
+  first,   // Only the first event.
+  none     // Nothing.
+};
+
+// Parse the array in parallel.
+//
+static vector<string>
+parse_parallel (const string& s,
+                size_t threads,
+                consume c = consume::element)
+{
+  vector<string> r;
+  mutex m;
+
+  parse_array_parallel (
+    s.data (), s.size (), "test",
+    [&r, &m, c] (parser& p, size_t i, const array_range&)
+    {
+      string e;
+      switch (c)
+      {
+      case consume::element:
+        {
+          e = element (p);
+          break;
+        }
+      case consume::drain:
+        {
+          e = element (p);
+          bool a (!p.next ());
+          assert (a);
+          break;
+        }
+      case consume::first:
+        {
+          p.next ();
+          break;
+        }
+      case consume::none:
+        break;
+      }
+
+      lock_guard<mutex> l (m);
+      if (r.size () <= i)
+        r.resize (i + 1);
+      r[i] = move (e);
+    },
+    threads);
+
+  return r;
+}
+
+// Return the location of each element's first event.
+//
+static string
+location (uint64_t l, uint64_t c, uint64_t p)
+{
+  return to_string (l) + ':' + to_string (c) + ':' + to_string (p);
+}
+
+static vector<string>
+locations (const string& s)
+{
+  vector<string> r;
+  parser p (s, "test");
+  p.next_expect (event::begin_array);
+  while (p.peek () != event::end_array)
+  {
+    event e (*p.next ());
+    r.push_back (location (p.line (), p.column (), p.position ()));
+
+    // Skip the rest of the element.
+    //
+    if (e == event::begin_object || e == event::begin_array)
+    {
+      for (size_t d (1); d != 0; )
+      {
+        e = *p.next ();
+
+        if (e == event::begin_object || e == event::begin_array)
+          ++d;
+        else if (e == event::end_object || e == event::end_array)
+          --d;
+      }
+    }
+  }
+  return r;
+}
+
+static vector<string>
+locations_parallel (const string& s, size_t threads)
+{
+  vector<string> r;
+  mutex m;
+
+  parse_array_parallel (
+    s.data (), s.size (), "test",
+    [&r, &m] (parser& p, size_t i, const array_range& o)
+    {
+      p.next ();
+      string l (location (o.input_line (p),
+                          o.input_column (p),
+                          o.input_position (p)));
+
+      lock_guard<mutex> g (m);
+      if (r.size () <= i)
+        r.resize (i + 1);
+      r[i] = move (l);
+    },
+    threads);
+
+  return r;
+}
+
+// Return the error location or empty string if there is no error.
+//
+template <typename F>
+static string
+error (F f)
+{
+  try
+  {
+    f ();
+  }
+  catch (const invalid_json_input& e)
+  {
+    return to_string (e.line) + ':' + to_string (e.column) + ':' +
+      to_string (e.position) + ':' + e.what ();
+  }
+  return string ();
+}
+
+int
+main ()
+{
+  // Large array of elements with nested commas, brackets, and quotes
+  // (escaped or not) in strings.
+  //
+  string s ("[\n");
+  for (size_t i (0); i != 40000; ++i)
+  {
+    if (i != 0)
+      s += ",\n";
+
+    switch (i % 5)
+    {
+    case 0: s += to_string (i); break;
+    case 1: s += "\"a,b]}\\\"[{\\\\\""; break;
+    case 2: s += "{\"x\": [1, 2, {\"y\": \"]\"}], \"z\": null}"; break;
+    case 3: s += "[[], {}, [true, false], \"" + string (100, 'q') + "\"]"; break;
+    case 4: s += "\"\\\\\""; break;
+    }
+  }
+  s += "\n]\n";
+
+  // Make it large enough to be split.
+  //
+  s.insert (1, 8 * 1024 * 1024, ' ');
+
+  vector<string> r (parse (s));
+  assert (r.size () == 40000);
+
+  for (size_t t: {1, 2, 3, 8})
+    assert (parse_parallel (s, t) == r);
+
+  // Unconsumed events are skipped.
+  //
+  assert (parse_parallel (s, 4, consume::first).size () == r.size ());
+  assert (parse_parallel (s, 4, consume::none).size () == r.size ());
+
+  // Elements drained to (and including) the absent event.
+  //
+  assert (parse_parallel (s, 4, consume::drain) == r);
+  assert (parse_parallel ("[1, [2], {}]", 1, consume::drain) ==
+          parse ("[1, [2], {}]"));
+
+  // Locations relative to the entire input text.
+  //
+  {
+    vector<string> l (locations (s));
+    for (size_t t: {1, 4})
+      assert (locations_parallel (s, t) == l);
+
+    // Ranges that begin in the middle of a line with escape sequences
+    // preceding them.
+    //
+    string u ("[");
+    for (size_t i (0); i != 600000; ++i)
+    {
+      if (i != 0)
+        u += ", ";
+
+      u += i % 2 == 0 ? "\"\\u0939\\t\"" : to_string (i);
+    }
+    u += "]";
+
+    assert (locations_parallel (u, 4) == locations (u));
+  }
+
+  // Small and empty arrays.
+  //
+  assert (parse_parallel ("[]", 4).empty ());
+  assert (parse_parallel (" [ \n ] ", 4).empty ());
+  assert (parse_parallel ("[1]", 4) == parse ("[1]"));
+  assert (parse_parallel ("[1, [2], {}]", 4) == parse ("[1, [2], {}]"));
+
+  // Errors are reported with the same location as the sequential parser.
+  //
+  for (size_t off: {size_t (100), s.size () / 2, s.size () - 100})
+  {
+    // Replace an element separator with a space.
+    //
+    string t (s);
+    size_t p (t.find (",\n", off));
+    t[p] = ' ';
+
+    // Note that the descriptions differ (missing separator vs unexpected
+    // byte) so only compare the locations.
+    //
+    auto loc = [] (const string& e)
+    {
+      return string (e, 0, e.find (':', e.find (':', e.find (':') + 1) + 1));
+    };
+
+    string e (error ([&t] {parse (t);}));
+    assert (!e.empty ());
+    assert (loc (error ([&t] {parse_parallel (t, 4);})) == loc (e));
+  }
+
+  for (const char* t: {"", "1", "{}", "[1,]", "[,1]", "[1,,2]", "[1}", "[1",
+                       "[\"1]", "[1] 2", "[1 2]"})
+  {
+    string e (error ([t] {parse_parallel (t, 4);}));
+    assert (!e.empty ());
+  }
+}
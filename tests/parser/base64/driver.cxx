@@ -0,0 +1,159 @@
+#include <string>
+#include <vector>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/serializer.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Decode the string value, returning "<error>" if it is invalid.
+//
+static string
+decode (const string& v, size_t c = string::npos)
+{
+  parser p ('"' + v + '"', "test");
+  assert (p.next () == event::string);
+
+  vector<char> b (c != string::npos ? c : v.size () / 4 * 3);
+  try
+  {
+    return string (b.data (), p.value_base64 (b.data (), b.size ()));
+  }
+  catch (const invalid_json_input&)
+  {
+    return "<error>";
+  }
+}
+
+static string
+encode (const string& v)
+{
+  string r;
+  buffer_serializer s (r);
+  s.value_base64 (v.data (), v.size ());
+  return r;
+}
+
+int
+main ()
+{
+  // RFC 4648 test vectors.
+  //
+  const char* vs[][2] = {
+    {"",       ""},
+    {"f",      "Zg=="},
+    {"fo",     "Zm8="},
+    {"foo",    "Zm9v"},
+    {"foob",   "Zm9vYg=="},
+    {"fooba",  "Zm9vYmE="},
+    {"foobar", "Zm9vYmFy"}};
+
+  for (const auto& v: vs)
+  {
+    assert (encode (v[0]) == '"' + string (v[1]) + '"');
+    assert (decode (v[1]) == v[0]);
+  }
+
+  // Invalid values.
+  //
+  assert (decode ("Zm9") == "<error>");
+  assert (decode ("Zm9v!A==") == "<error>");
+  assert (decode ("Z===") == "<error>");
+  assert (decode ("Zm=v") == "<error>");
+  assert (decode ("Zm9vYmFy", 5) == "<error>");
+  assert (decode ("Zm9vYmE=", 5) == "fooba");
+
+  // Round trip of all byte values in multiple blocks and within an object.
+  //
+  {
+    string d;
+    for (size_t i (0); i != 10000; ++i)
+      d += static_cast<char> (i * 7 % 256);
+
+    for (size_t n: {d.size (), d.size () - 1, d.size () - 2})
+    {
+      string t;
+      {
+        buffer_serializer s (t, 0);
+        s.begin_object ();
+        s.member_name ("data");
+        s.value_base64 (d.data (), n);
+        s.end_object ();
+      }
+
+      parser p (t, "test");
+      p.next_expect (event::begin_object);
+      p.next_expect_name ("data");
+      p.next_expect (event::string);
+
+      vector<char> b (p.data ().second / 4 * 3);
+      assert (string (b.data (), p.value_base64 (b.data (), b.size ())) ==
+              d.substr (0, n));
+
+      // Also from the cached value.
+      //
+      p.value ();
+      assert (p.value_base64 (b.data (), b.size ()) == n);
+
+      p.next_expect (event::end_object);
+    }
+
+    // Encoding into a small buffer that is flushed on overflow so that the
+    // value is split across many overflow calls.
+    //
+    for (size_t c: {5, 7, 64})
+    {
+      for (size_t n: {d.size (), d.size () - 1, d.size () - 2})
+      {
+        string t;
+        {
+          char b[64];
+          buffer_serializer s (
+            b, c,
+            [] (void* d, event, buffer_serializer::buffer& b, size_t)
+            {
+              static_cast<string*> (d)->append (static_cast<char*> (b.data),
+                                                b.size);
+              b.size = 0;
+            },
+            [] (void* d, event, buffer_serializer::buffer& b)
+            {
+              static_cast<string*> (d)->append (static_cast<char*> (b.data),
+                                                b.size);
+              b.size = 0;
+            },
+            &t,
+            0);
+
+          s.value_base64 (d.data (), n);
+        }
+
+        assert (t == encode (d.substr (0, n)));
+      }
+    }
+  }
+
+  // Insufficient space in a fixed buffer.
+  //
+  {
+    char b[8];
+    size_t n (0);
+    buffer_serializer s (b, n, sizeof (b));
+
+    try
+    {
+      s.value_base64 ("foobar", 6);
+      assert (false);
+    }
+    catch (const invalid_json_output& e)
+    {
+      assert (e.event && *e.event == event::string);
+      assert (e.code == invalid_json_output::error_code::buffer_overflow);
+    }
+  }
+}
@@ -0,0 +1,191 @@
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+using stud::optional;
+
+// Event, value, and depth as a string.
+//
+static string
+token (event e, const string& v, size_t d)
+{
+  return to_string (static_cast<int> (e)) + ':' + v + ':' + to_string (d);
+}
+
+// Parse the entire input with next() returning the tokens with the absent
+// events as empty strings.
+//
+static vector<string>
+parse (const string& s, bool mv)
+{
+  vector<string> r;
+  parser p (s, "test", mv);
+
+  size_t d (0);
+  for (size_t n (0); n != 2; )
+  {
+    optional<event> e (p.next ());
+
+    if (!e)
+    {
+      r.push_back (string ());
+      n++;
+      continue;
+    }
+
+    n = 0;
+
+    if (*e == event::end_object || *e == event::end_array)
+      d--;
+
+    pair<const char*, size_t> v (p.data ());
+    r.push_back (token (*e, v.first != nullptr ? string (v.first, v.second) : "", d));
+
+    if (*e == event::begin_object || *e == event::begin_array)
+      d++;
+  }
+
+  return r;
+}
+
+// As above but with next_batch().
+//
+static vector<string>
+parse_batch (parser& p, size_t bn, bool peek)
+{
+  vector<string> r;
+
+  vector<parser::token> ts (bn);
+  string d;
+
+  for (size_t n (0); n != 2; d.clear ())
+  {
+    if (peek)
+      p.peek ();
+
+    size_t k (p.next_batch (ts.data (), bn, d));
+
+    for (size_t i (0); i != k; ++i)
+    {
+      const parser::token& t (ts[i]);
+      r.push_back (token (t.type,
+                          t.data != nullptr ? string (t.data, t.size) : "",
+                          t.depth));
+    }
+
+    // The parser state corresponds to the last event (unless it is
+    // absent).
+    //
+    if (k == bn)
+    {
+      const parser::token& t (ts[k - 1]);
+
+      if (t.type == event::name)
+        assert (p.name () == string (t.data, t.size));
+      else if (t.type == event::string || t.type == event::number)
+        assert (p.value () == string (t.data, t.size));
+    }
+
+    if (k != bn)
+    {
+      r.push_back (string ());
+      n = k == 0 ? n + 1 : 1;
+    }
+    else
+      n = 0;
+  }
+
+  return r;
+}
+
+static vector<string>
+parse_batch (const string& s, bool mv, size_t bn, bool peek = false)
+{
+  parser p (s, "test", mv);
+  return parse_batch (p, bn, peek);
+}
+
+static vector<string>
+parse_batch_stream (const string& s, bool mv, size_t bn, bool peek = false)
+{
+  istringstream is (s);
+  parser p (is, "test", mv);
+  return parse_batch (p, bn, peek);
+}
+
+int
+main ()
+{
+  const string single (
+    "{\"a\": [1, \"x\", true, null, {\"b\": {}}], \"c\": false, \"d\": [],"
+    " \"e\\\"\": \"\\u0444\\\"\", \"\": \"\"}");
+
+  const string multi ("1\n[\"a\", [2]]\n{\"b\": null}\n\"c\"");
+
+  vector<string> rs (parse (single, false));
+  vector<string> rm (parse (multi, true));
+
+  for (size_t bn: {1, 2, 3, 7, 100})
+  {
+    assert (parse_batch (single, false, bn) == rs);
+    assert (parse_batch (single, false, bn, true) == rs);
+    assert (parse_batch (multi, true, bn) == rm);
+    assert (parse_batch (multi, true, bn, true) == rm);
+
+    assert (parse_batch_stream (single, false, bn) == rs);
+    assert (parse_batch_stream (single, false, bn, true) == rs);
+    assert (parse_batch_stream (multi, true, bn) == rm);
+    assert (parse_batch_stream (multi, true, bn, true) == rm);
+  }
+
+  // Values are not copied from the memory buffer unless escaped.
+  //
+  {
+    const string s ("[\"abc\", 123, \"a\\\"b\", \"\\\"\\\"x\", \"\", true]");
+
+    parser p (s, "test");
+
+    parser::token ts[8];
+    string d;
+    assert (p.next_batch (ts, 8, d) == 8);
+
+    assert (ts[0].data == nullptr);
+    assert (ts[1].data == s.data () + 2 && ts[1].size == 3);
+    assert (ts[2].data == s.data () + 8 && ts[2].size == 3);
+    assert (ts[3].data == d.data () && ts[3].size == 3);
+    assert (ts[4].data == d.data () + 3 && ts[4].size == 3);
+    assert (ts[5].data == s.data () + 31 && ts[5].size == 0);
+    assert (string (ts[6].data, ts[6].size) == "true");
+    assert (ts[7].data == nullptr);
+
+    assert (d == "a\"b\"\"x");
+  }
+
+  // Mixing with next().
+  //
+  {
+    parser p (single, "test");
+    assert (p.next () == event::begin_object);
+    assert (p.next () == event::name);
+
+    parser::token ts[2];
+    string d;
+    assert (p.next_batch (ts, 2, d) == 2);
+    assert (ts[0].type == event::begin_array && ts[0].depth == 1);
+    assert (ts[1].type == event::number && ts[1].depth == 2);
+    assert (string (ts[1].data, ts[1].size) == "1" && d.empty ());
+    assert (p.value<int> () == 1);
+
+    assert (p.next () == event::string);
+    assert (p.value () == "x");
+  }
+}
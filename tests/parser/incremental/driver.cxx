@@ -0,0 +1,296 @@
+#include <string>
+#include <vector>
+#include <algorithm> // min()
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+using stud::optional;
+using stud::nullopt;
+
+// Parse the input to the end returning the events (with their raw values
+// and locations) and the error, if any. Note that the locations of the
+// absent events are not included since in the multi-value mode they depend
+// on whether the following separators have been skipped. The next function
+// should return the next event (see below).
+//
+template <typename N>
+static vector<string>
+parse (parser& p, const N& next)
+{
+  vector<string> r;
+
+  try
+  {
+    for (size_t n (0); n != 2; )
+    {
+      optional<event> e (next ());
+
+      if (!e)
+      {
+        r.push_back ("-");
+        n++;
+        continue;
+      }
+
+      n = 0;
+
+      pair<const char*, size_t> v (p.data ());
+      r.push_back (to_string (static_cast<int> (*e)) + ':' +
+                   (v.first != nullptr ? string (v.first, v.second) : "") +
+                   '@' + to_string (p.line ()) +
+                   ':' + to_string (p.column ()) +
+                   ':' + to_string (p.position ()));
+    }
+  }
+  catch (const invalid_json_input& e)
+  {
+    r.push_back (string ("error@") + to_string (e.line) +
+                 ':' + to_string (e.column) +
+                 ':' + to_string (e.position) +
+                 ": " + e.what ());
+  }
+
+  return r;
+}
+
+static vector<string>
+parse_buffer (const string& s, bool mv = false, const char* sep = nullptr)
+{
+  parser p (s, "test", mv, sep);
+  return parse (p, [&p] () {return p.next ();});
+}
+
+// Parse supplying the input in chunks of the specified size as required,
+// optionally peeking at each event first.
+//
+static vector<string>
+parse_incremental (const string& s,
+                   size_t chunk,
+                   bool peek = false,
+                   bool mv = false,
+                   const char* sep = nullptr)
+{
+  incremental_parser p ("test", mv, sep);
+
+  size_t i (0);
+  auto next = [&s, chunk, peek, &p, &i] () -> optional<event>
+  {
+    while (!p.ready ())
+    {
+      if (i != s.size ())
+      {
+        size_t n (min (chunk, s.size () - i));
+        p.feed (s.data () + i, n);
+        i += n;
+      }
+      else
+        p.finish ();
+    }
+
+    if (peek)
+    {
+      optional<event> e (p.peek ());
+      assert (p.ready ());
+      assert (p.next () == e);
+      return e;
+    }
+
+    return p.next ();
+  };
+
+  return parse (p, next);
+}
+
+// Check that the incremental parsing produces the same result as the
+// buffer parsing for all the chunk sizes.
+//
+static void
+check (const string& s, bool mv = false, const char* sep = nullptr)
+{
+  const vector<string> r (parse_buffer (s, mv, sep));
+
+  for (size_t c (1); c <= s.size () + 1; ++c)
+  {
+    assert (parse_incremental (s, c, false, mv, sep) == r);
+    assert (parse_incremental (s, c, true, mv, sep) == r);
+  }
+}
+
+int
+main ()
+{
+  // Single value.
+  //
+  check ("{\"a\": [1, -2.5e+3, true, false, null, \"\\u0441\\\"\\\\\"],\n"
+         " \"b\" : {\"c\":{}, \"d\":[]}, \"\\u00e9\": \"\"}\n");
+  check ("123");
+  check ("  \"abc\"  ");
+  check ("true");
+  check ("[]");
+
+  // Invalid.
+  //
+  check ("");
+  check ("[1, 2");
+  check ("[1, 2,]");
+  check ("{\"a\" 1}");
+  check ("{\"a\": tru}");
+  check ("[\"abc");
+  check ("[1] 2");
+  check ("[1]]");
+  check ("[01]");
+
+  // Multiple values.
+  //
+  check ("", true);
+  check (" \n ", true);
+  check ("1 2 3", true);
+  check ("1\n[2]\n{\"a\":3}\n\"x\"null", true);
+  check ("{}{}[]", true, nullptr);
+  check ("1\n2\n[3]\n", true, "\n");
+  check ("\x1E[1]\n\x1E[2]\n\x1E", true, "\x1E");
+  check ("[1, 2\n", true);
+
+  // Events are available as soon as possible.
+  //
+  {
+    incremental_parser p ("test");
+    assert (!p.ready ());
+
+    p.feed ("[", 1);
+    assert (p.ready () && p.next () == event::begin_array);
+    assert (!p.ready ());
+
+    p.feed ("\"ab", 3);
+    assert (!p.ready ());
+    p.feed ("c\\", 2);
+    assert (!p.ready ());
+    p.feed ("\"\"", 2);
+    assert (p.ready () && p.next () == event::string);
+    assert (p.value () == "abc\"");
+
+    p.feed (",  12", 5);
+    assert (!p.ready ());
+    p.feed ("3]", 2);
+    assert (p.ready () && p.next () == event::number);
+    assert (p.value () == "123");
+    assert (p.ready () && p.next () == event::end_array);
+    assert (!p.ready ());
+
+    p.feed ("\n", 1);
+    assert (!p.ready ());
+    p.finish ();
+    assert (p.ready () && p.next () == nullopt);
+  }
+
+  // In the multi-value mode, the absent event is available as soon as the
+  // value is complete.
+  //
+  {
+    incremental_parser p ("test", true, "\n");
+
+    p.feed ("{}", 2);
+    assert (p.ready () && p.next () == event::begin_object);
+    assert (p.ready () && p.next () == event::end_object);
+    assert (p.ready () && p.next () == nullopt);
+    assert (!p.ready ());
+
+    p.feed ("\n\n", 2);
+    assert (!p.ready ());
+    p.feed ("true", 4);
+    assert (!p.ready ());
+    p.finish ();
+    assert (p.ready () && p.next () == event::boolean);
+    assert (p.ready () && p.next () == nullopt);
+    assert (p.ready () && p.next () == nullopt);
+  }
+
+  // Missing separator is diagnosed when parsing the next value.
+  //
+  {
+    incremental_parser p ("test", true, "\n");
+
+    p.feed ("[1] [2]", 7);
+    assert (p.ready () && p.next () == event::begin_array);
+    assert (p.ready () && p.next () == event::number);
+    assert (p.ready () && p.next () == event::end_array);
+    assert (p.ready () && p.next () == nullopt);
+    assert (p.ready ());
+
+    try
+    {
+      p.next ();
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (e.position == 5);
+      assert (string (e.what ()) == "missing separator between JSON values");
+    }
+  }
+
+  // Incomplete token that exceeds the limits is diagnosed without waiting
+  // for the rest of it.
+  //
+  {
+    incremental_parser p ("test");
+
+    parser::limits l;
+    l.max_string = 4;
+    p.set_limits (l);
+
+    p.feed ("[\"", 2);
+    assert (p.ready () && p.next () == event::begin_array);
+
+    size_t i (0);
+    for (; !p.ready (); ++i)
+      p.feed ("\\u0041", 6);
+
+    assert (i == 5);
+
+    try
+    {
+      p.next ();
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (string (e.what ()) == "string length limit exceeded");
+    }
+  }
+
+  {
+    incremental_parser p ("test");
+
+    parser::limits l;
+    l.max_bytes = 10;
+    p.set_limits (l);
+
+    p.feed ("[1, ", 4);
+    assert (p.ready () && p.next () == event::begin_array);
+    assert (p.ready () && p.next () == event::number);
+    assert (!p.ready ());
+
+    p.feed ("      ", 6);
+    assert (!p.ready ());
+    p.feed (" ", 1);
+    assert (p.ready ());
+
+    try
+    {
+      p.next ();
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (string (e.what ()) == "input size limit exceeded");
+    }
+  }
+}
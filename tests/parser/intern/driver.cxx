@@ -0,0 +1,94 @@
+#include <string>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+int
+main ()
+{
+  // Ids and re-interning.
+  //
+  {
+    parser p ("{}", "test");
+
+    assert (p.intern ("a") == 0);
+    assert (p.intern (string ("b")) == 1);
+    assert (p.intern ("") == 2);
+    assert (p.intern ("a") == 0);
+    assert (p.intern (string ("b")) == 1);
+    assert (p.intern ("") == 2);
+  }
+
+  // Names with embedded NUL characters.
+  //
+  {
+    parser p ("{\"a\\u0000b\":1,\"a\":2}", "test");
+
+    const string n ("a\0b", 3);
+    const size_t id (p.intern (n));
+
+    assert (id == 0 && p.intern ("a") == 1);
+    assert (p.intern (n.data (), n.size ()) == id);
+
+    assert (p.next () == event::begin_object);
+    assert (p.next () == event::name);
+    assert (p.name_id () == id);
+    p.next_expect (event::number);
+    assert (p.next () == event::name);
+    assert (p.name_id () == 1);
+  }
+
+  // Lookup in multi-value mode, including after name() and peek().
+  //
+  {
+    parser p ("{\"id\":1,\"x\":2,\"name\":\"a\",\"\":null}\n"
+              "{\"name\":\"b\",\"id\":2}",
+              "test",
+              true /* multi_value */);
+
+    const size_t id (p.intern ("id")), name (p.intern ("name"));
+
+    // Many more names to force rehashing.
+    //
+    for (size_t i (0); i != 100; ++i)
+      p.intern ("n" + to_string (i));
+
+    assert (p.intern ("id") == id && p.intern ("name") == name);
+
+    assert (p.next () == event::begin_object);
+
+    assert (p.next () == event::name);
+    assert (p.name_id () == id);
+    p.next_expect (event::number);
+
+    assert (p.next () == event::name);
+    assert (p.name_id () == string::npos);
+    p.next_expect (event::number);
+
+    assert (p.next () == event::name);
+    assert (p.name () == "name");
+    assert (p.name_id () == name);
+    p.next_expect (event::string);
+
+    assert (p.next () == event::name);
+    assert (p.name_id () == string::npos);
+    p.next_expect (event::null);
+
+    assert (p.next () == event::end_object);
+    assert (!p.next ());
+
+    assert (p.next () == event::begin_object);
+    assert (p.next () == event::name);
+    assert (p.peek () == event::string);
+    assert (p.name_id () == name);
+    p.next_expect (event::string);
+    assert (p.next () == event::name);
+    assert (p.name_id () == id);
+  }
+}
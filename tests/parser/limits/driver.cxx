@@ -0,0 +1,190 @@
+#include <string>
+#include <sstream>
+#include <stdexcept> // invalid_argument
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Parse the input to the end returning the limit error description, if any.
+//
+static string
+parse (const string& s, const parser::limits& l,
+       void* storage = nullptr, size_t storage_size = 0)
+{
+  parser p (s, "test");
+  p.set_limits (l, storage, storage_size);
+
+  try
+  {
+    while (p.next ()) ;
+  }
+  catch (const invalid_json_input& e)
+  {
+    return e.what ();
+  }
+
+  return string ();
+}
+
+static string
+parse_stream (const string& s, const parser::limits& l)
+{
+  istringstream is (s);
+  parser p (is, "test");
+  p.set_limits (l);
+
+  try
+  {
+    while (p.next ()) ;
+  }
+  catch (const invalid_json_input& e)
+  {
+    return e.what ();
+  }
+
+  return string ();
+}
+
+int
+main ()
+{
+  using limits = parser::limits;
+
+  // No limits.
+  //
+  {
+    limits l;
+    assert (parse ("{\"a\":[1,2,{\"b\":\"c\"}]}", l).empty ());
+  }
+
+  // String length.
+  //
+  {
+    limits l;
+    l.max_string = 5;
+
+    assert (parse ("[\"abcde\", 12345]", l).empty ());
+    assert (parse ("\"abcdef\"", l) == "string length limit exceeded");
+    assert (parse ("123456", l) == "string length limit exceeded");
+    assert (parse ("{\"abcdef\":1}", l) == "string length limit exceeded");
+  }
+
+  // String length enforced before the string is buffered in full.
+  //
+  {
+    limits l;
+    l.max_string = 2000;
+
+    string s ('"' + string (1000000, 'x') + '"');
+    assert (parse (s, l) == "string length limit exceeded");
+    assert (parse_stream (s, l) == "string length limit exceeded");
+  }
+
+  // Fixed storage.
+  //
+  {
+    limits l;
+    char buf[1024];
+
+    string s ('"' + string (1023, 'x') + '"');
+    assert (parse (s, l, buf, sizeof (buf)).empty ());
+
+    s = '"' + string (1024, 'x') + '"';
+    assert (parse (s, l, buf, sizeof (buf)) ==
+            "string length limit exceeded");
+
+    // Storage smaller than the initial allocation.
+    //
+    try
+    {
+      parser p ("\"x\"", "test");
+      p.set_limits (l, buf, 1023);
+      assert (false);
+    }
+    catch (const invalid_argument&) {}
+  }
+
+  // Limits set after parsing started.
+  //
+  {
+    limits l;
+
+    parser p ("[1]", "test");
+    assert (p.peek () == event::begin_array);
+
+    try
+    {
+      p.set_limits (l);
+      assert (false);
+    }
+    catch (const invalid_argument&) {}
+  }
+
+  // Nesting depth.
+  //
+  {
+    limits l;
+    l.max_depth = 2;
+
+    assert (parse ("[{\"a\":1}]", l).empty ());
+    assert (parse ("[[[1]]]", l) == "nesting depth limit exceeded");
+    assert (parse ("{\"a\":{\"b\":{}}}", l) ==
+            "nesting depth limit exceeded");
+  }
+
+  // Input size.
+  //
+  {
+    limits l;
+    l.max_bytes = 10;
+
+    assert (parse ("[1,2,3,4]", l).empty ());
+    assert (parse ("[1,2,3,4,5,6]", l) == "input size limit exceeded");
+    assert (parse_stream ("[1,2,3,4,5,6]", l) ==
+            "input size limit exceeded");
+  }
+
+  // Object members.
+  //
+  {
+    limits l;
+    l.max_members = 2;
+
+    assert (parse ("{\"a\":1,\"b\":{\"c\":3,\"d\":4},\"x\":[\"y\"]}", l) ==
+            "object member limit exceeded");
+    assert (parse ("{\"a\":1,\"b\":{\"c\":3,\"d\":4}}", l).empty ());
+    assert (parse ("[\"a\",\"b\",\"c\"]", l).empty ());
+    assert (parse ("{\"a\":\"b\",\"c\":\"d\",\"e\":\"f\"}", l) ==
+            "object member limit exceeded");
+  }
+
+  // Error location.
+  //
+  {
+    limits l;
+    l.max_depth = 1;
+
+    parser p ("[[1]]", "test");
+    p.set_limits (l);
+
+    assert (p.next () == event::begin_array);
+
+    try
+    {
+      p.next ();
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (e.name == "test");
+      assert (e.line == 1);
+      assert (e.position == 2);
+    }
+  }
+}
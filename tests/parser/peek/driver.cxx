@@ -279,5 +279,64 @@ main ()
     assert (p.value () == "");
   }
 
+  // The raw data of the parsed event remains valid after a peek and the
+  // name and value can still be retrieved.
+  //
+  {
+    parser p ("{\"name\": \"value\", \"n\": 123}", "test");
+    assert (p.next () == event::begin_object);
+    assert (p.next () == event::name);
+
+    const char* d (p.data ().first);
+    assert (p.peek () == event::string);
+    assert (string (p.data ().first) == "value");
+    assert (string (d) == "name");
+    assert (p.name () == "name");
+
+    assert (p.next () == event::string);
+    d = p.data ().first;
+    assert (p.peek () == event::name);
+    assert (p.peek () == event::name);
+    assert (string (d) == "value");
+    assert (p.value () == "value");
+
+    assert (p.next () == event::name);
+    assert (p.peek () == event::number);
+    assert (p.name () == "n");
+    assert (p.next () == event::number);
+    assert (p.peek () == event::end_object);
+    assert (p.value<int> () == 123);
+  }
+
+  // Value pending.
+  //
+  {
+    parser p ("[1] 2 3", "test", true);
+    assert (!p.value_pending ());
+
+    assert (p.peek () == event::begin_array);
+    assert (p.value_pending ());
+    assert (p.next () == event::begin_array);
+    assert (p.next () == event::number);
+    assert (p.next () == event::end_array);
+    assert (p.value_pending ());
+    assert (p.peek () == nullopt);
+    assert (p.value_pending ());
+    assert (p.next () == nullopt);
+    assert (!p.value_pending ());
+
+    assert (p.peek () == event::number); // Not consumed at all.
+    assert (p.value_pending ());
+    while (p.next ()) ;
+    assert (!p.value_pending ());
+
+    assert (p.next () == event::number);
+    assert (p.value_pending ());
+    assert (p.next () == nullopt);
+    assert (!p.value_pending ());
+    assert (p.next () == nullopt);
+    assert (!p.value_pending ());
+  }
+
   return 0;
 }
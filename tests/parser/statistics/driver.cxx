@@ -0,0 +1,109 @@
+#include <string>
+#include <cstring> // strlen()
+#include <sstream>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+int
+main ()
+{
+  // Nothing to test unless the library is built with statistics enabled.
+  //
+#ifdef LIBSTUD_JSON_STATISTICS
+  auto events = [] (const parser::statistics& s, event e)
+  {
+    return s.events[static_cast<size_t> (e) - 1];
+  };
+
+  const char* text ("{\"a\": [1, \"x\\ty\"], \"b\\u0041\": {\"c\": null}}\n"
+                    "[true, \"z\"]\n"
+                    "2");
+
+  auto verify = [&events, text] (parser& p)
+  {
+    while (p.peek ())
+    {
+      while (p.next ()) ;
+    }
+
+    const parser::statistics& s (p.stats ());
+
+    assert (s.bytes == strlen (text));
+    assert (events (s, event::begin_object) == 2);
+    assert (events (s, event::end_object) == 2);
+    assert (events (s, event::begin_array) == 2);
+    assert (events (s, event::end_array) == 2);
+    assert (events (s, event::name) == 3);
+    assert (events (s, event::string) == 2);
+    assert (events (s, event::number) == 2);
+    assert (events (s, event::boolean) == 1);
+    assert (events (s, event::null) == 1);
+    assert (s.strings == 5);
+    assert (s.escaped_strings == 2);
+    assert (s.max_depth == 2);
+    assert (s.string_buffer_size != 0);
+    assert (s.values == 3);
+  };
+
+  {
+    parser p (text, "test", true /* multi_value */);
+    verify (p);
+  }
+
+  {
+    istringstream is (text);
+    parser p (is, "test", true /* multi_value */);
+    verify (p);
+  }
+
+  // Peek copies (only with the fixed storage).
+  //
+  {
+    auto test = [] (bool storage)
+    {
+      char buf[1024];
+
+      parser p ("{\"a\": 1, \"b\": [2]}", "test");
+
+      if (storage)
+        p.set_limits (parser::limits (), buf, sizeof (buf));
+
+      p.next ();                     // {
+      p.next ();                     // "a"
+      p.peek ();                     // 1 (copies the name)
+      assert (p.name () == "a");
+      p.next ();
+      p.peek ();                     // "b" (copies the value)
+      assert (p.value () == "1");
+      p.next ();
+      p.next ();                     // [
+      p.peek ();                     // 2 (nothing to copy)
+
+      return p.stats ().peek_copies;
+    };
+
+    assert (test (false) == 0);
+    assert (test (true) == 2);
+  }
+
+  // Stack reallocations.
+  //
+  {
+    string t (100, '[');
+    t += string (100, ']');
+
+    parser p (t, "test");
+    while (p.next ()) ;
+
+    assert (p.stats ().max_depth == 100);
+    assert (p.stats ().stack_reallocations > 1);
+  }
+#endif
+}
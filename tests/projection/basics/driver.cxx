@@ -0,0 +1,67 @@
+// Usage: argv[0] (--keep|--drop|--mask <path>)*
+//
+// Transform the multi-value JSON input text read from stdin according to
+// the projection specification.
+
+#include <string>
+#include <iostream>
+
+#include <libstud/json/parser.hxx>
+#include <libstud/json/projection.hxx>
+#include <libstud/json/serializer.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+int
+main (int argc, const char* argv[])
+{
+  projection pr;
+
+  try
+  {
+    for (int i (1); i + 1 < argc; i += 2)
+    {
+      const string o (argv[i]);
+      const string p (argv[i + 1]);
+
+      if (o == "--keep")
+        pr.keep (p);
+      else if (o == "--drop")
+        pr.drop (p);
+      else if (o == "--mask")
+        pr.mask (p);
+      else
+        assert (false);
+    }
+  }
+  catch (const invalid_argument& e)
+  {
+    cerr << e.what () << endl;
+    return 1;
+  }
+
+  parser p (cin, "<stdin>", true /* multi_value */);
+  stream_serializer s (cout, 0);
+
+  try
+  {
+    if (pr.transform (p, s) != 0)
+      cout << endl;
+
+    return 0;
+  }
+  catch (const invalid_json_output& e)
+  {
+    cerr << e.what () << endl;
+  }
+  catch (const invalid_json_input& e)
+  {
+    cerr << e.what () << endl;
+  }
+
+  return 1;
+}
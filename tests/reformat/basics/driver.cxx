@@ -0,0 +1,76 @@
+// Usage: argv[0] [--pretty] [--member]
+//
+// --pretty  -- enable pretty-printing
+// --member  -- copy each top-level object's first member value with
+//              copy_value() rather than the entire value with reformat()
+
+#include <iostream>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/reformat.hxx>
+#include <libstud/json/serializer.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+int
+main (int argc, const char* argv[])
+{
+  bool pretty (false);
+  bool member (false);
+
+  for (int i (1); i < argc; i++)
+  {
+    const string o (argv[i]);
+
+    if (o == "--pretty")
+      pretty = true;
+    else if (o == "--member")
+      member = true;
+  }
+
+  parser p (cin, "<stdin>", true /* multi_value */);
+  stream_serializer s (cout, pretty ? 2 : 0);
+
+  try
+  {
+    if (!member)
+    {
+      if (reformat (p, s) != 0)
+        cout << endl;
+    }
+    else
+    {
+      while (p.peek ())
+      {
+        p.next_expect (event::begin_object);
+        p.next_expect (event::name);
+        copy_value (p, s, *p.next ());
+
+        // Skip the remaining members.
+        //
+        while (p.next_expect (event::name, event::end_object))
+          p.next_expect_value_skip ();
+
+        assert (!p.next ());
+      }
+      cout << endl;
+    }
+
+    return 0;
+  }
+  catch (const invalid_json_output& e)
+  {
+    cerr << e.what () << endl;
+  }
+  catch (const invalid_json_input& e)
+  {
+    cerr << e.what () << endl;
+  }
+
+  return 1;
+}
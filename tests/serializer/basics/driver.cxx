@@ -1,8 +1,15 @@
 #include <limits>
+#include <vector>
+#include <cstdio>  // tmpfile(), fileno()
 #include <cstddef> // size_t
 #include <cstring> // memcmp()
 #include <sstream>
 
+#ifndef _WIN32
+#  include <fcntl.h>  // fcntl()
+#  include <unistd.h> // pipe(), read(), close()
+#endif
+
 #include <libstud/optional.hxx>
 #include <libstud/json/serializer.hxx>
 
@@ -254,6 +261,417 @@ main ()
     }
   }
 
+  // Fragments.
+  //
+  {
+    // Serialize array elements [b, e) as objects with a nested array.
+    //
+    auto elements = [] (buffer_serializer& s, size_t b, size_t e)
+    {
+      for (size_t i (b); i != e; ++i)
+      {
+        s.begin_object ();
+        s.member ("i", i);
+        s.member_begin_array ("a");
+        s.value (i);
+        s.end_array ();
+        s.end_object ();
+      }
+    };
+
+    for (size_t ind: {0, 2})
+    {
+      // Array.
+      //
+      {
+        string e;
+        {
+          buffer_serializer s (e, ind);
+          s.begin_array ();
+          elements (s, 0, 5);
+          s.end_array ();
+        }
+
+        string b, f1, f2, f3;
+        buffer_serializer s (b, ind);
+        s.begin_array ();
+        elements (s, 0, 1);
+
+        buffer_serializer s1 (f1, ind), s2 (f2, ind), s3 (f3, ind);
+        s1.begin_fragment (s, 1);
+        s2.begin_fragment (s, 3);
+        s3.begin_fragment (s, 3);   // Empty.
+        elements (s2, 3, 5);
+        elements (s1, 1, 3);
+
+        s.splice_fragment (f1, 2);
+        s.splice_fragment (f3, 0);
+        s.splice_fragment (f2, 2);
+        s.end_array ();
+
+        assert (b == e);
+      }
+
+      // Object, with the fragment first.
+      //
+      {
+        string e;
+        {
+          buffer_serializer s (e, ind);
+          s.begin_object ();
+          s.member ("a", 1);
+          s.member ("b", 2);
+          s.member ("c", 3);
+          s.end_object ();
+        }
+
+        string b, f;
+        buffer_serializer s (b, ind);
+        s.begin_object ();
+
+        buffer_serializer s1 (f, ind);
+        s1.begin_fragment (s, 0);
+        s1.member ("a", 1);
+        s1.member ("b", 2);
+
+        s.splice_fragment (f, 2);
+        s.member ("c", 3);
+        s.end_object ();
+
+        assert (b == e);
+      }
+    }
+
+    // Fragment value completeness.
+    //
+    {
+      string b, f;
+      buffer_serializer s (b);
+      s.begin_object ();
+
+      buffer_serializer s1 (f);
+      s1.begin_fragment (s, 0);
+      assert (s1.next (event::name, {"a", 1}));
+      assert (next_throws (error::invalid_value, s1, nullopt));
+    }
+
+    {
+      string b, f;
+      buffer_serializer s (b);
+      s.begin_array ();
+
+      buffer_serializer s1 (f);
+      s1.begin_fragment (s, 0);
+      assert (s1.next (event::begin_array));
+      assert (!s1.next (event::end_array));
+      assert (next_throws (error::unexpected_event, s1, event::end_array));
+    }
+
+    // Invalid fragment starts.
+    //
+    {
+      auto begin_throws = [] (buffer_serializer& s, const buffer_serializer& p)
+      {
+        try
+        {
+          s.begin_fragment (p, 0);
+          return false;
+        }
+        catch (const invalid_json_output& e)
+        {
+          return e.code == error::unexpected_event;
+        }
+      };
+
+      string b, f;
+      buffer_serializer s (b);
+
+      {
+        buffer_serializer s1 (f);
+        assert (begin_throws (s1, s)); // Not inside array or object.
+      }
+
+      s.begin_object ();
+      s.next (event::name, {"a", 1});
+
+      {
+        buffer_serializer s1 (f);
+        assert (begin_throws (s1, s)); // Value expected.
+      }
+
+      s.begin_array ();
+
+      {
+        buffer_serializer s1 (f, 4);
+        assert (begin_throws (s1, s)); // Indentation mismatch.
+      }
+
+      {
+        buffer_serializer s1 (f);
+        s1.value (1);
+        assert (begin_throws (s1, s)); // Not in initial state.
+      }
+    }
+  }
+
+  // Checkpoint and rollback.
+  //
+  {
+    // No mark.
+    //
+    {
+      string b;
+      buffer_serializer s (b);
+      assert (!s.rollback ());
+    }
+
+    for (size_t ind: {0, 2})
+    {
+      string e;
+      {
+        buffer_serializer s (e, ind);
+        s.begin_array ();
+        s.value (1);
+        s.begin_object ();
+        s.member ("b", 2);
+        s.end_object ();
+        s.end_array ();
+      }
+
+      string b;
+      buffer_serializer s (b, ind);
+      s.begin_array ();
+      s.value (1);
+      s.mark ();
+
+      // Discard a partially serialized nested value.
+      //
+      s.begin_object ();
+      s.member ("a", 1);
+      s.member_begin_array ("x");
+      s.value ("y");
+      assert (s.rollback ());
+
+      // Again, after rolling back.
+      //
+      s.value (2);
+      assert (s.rollback ());
+
+      s.begin_object ();
+      s.member ("b", 2);
+      s.end_object ();
+      s.end_array ();
+
+      assert (b == e);
+
+      // Invalidated by closing the array that was open at the mark.
+      //
+      assert (!s.rollback ());
+    }
+
+    // Top-level values.
+    //
+    {
+      string b;
+      buffer_serializer s (b);
+      s.value (1);
+      s.mark ();
+      s.value (2);
+      s.begin_array ();
+      assert (s.rollback ());
+      s.value (3);
+      assert (b == "1\n3");
+    }
+
+    // The target reflects the rollback immediately.
+    //
+    {
+      {
+        string b;
+        buffer_serializer s (b, 0);
+        s.value (1);
+        s.mark ();
+        s.begin_object ();
+        s.member ("a", 2);
+        assert (s.rollback ());
+        assert (b == "1");
+      }
+
+      {
+        string b;
+        buffer_serializer s (b, 0);
+        s.value (1);
+        s.mark ();
+        s.value (2);
+        assert (b == "1\n2");
+        assert (s.rollback ());
+        assert (b == "1");
+      }
+
+      {
+        vector<char> b;
+        buffer_serializer s (b, 0);
+        s.value (1);
+        s.mark ();
+        s.value (2);
+        s.begin_array ();
+        assert (s.rollback ());
+        assert (string (b.data (), b.size ()) == "1");
+      }
+
+      {
+        block_buffer bb (64);
+        buffer_serializer s (bb, 0);
+        s.value (1);
+        s.mark ();
+        s.value (2);
+        assert (bb.string () == "1\n2");
+        assert (s.rollback ());
+        assert (bb.string () == "1");
+
+        s.begin_array ();
+        s.value (3);
+        assert (s.rollback ());
+        assert (bb.string () == "1");
+      }
+
+      // Mark before anything has been allocated.
+      //
+      {
+        block_buffer bb (64);
+        buffer_serializer s (bb, 0);
+        s.mark ();
+        s.value (1);
+        assert (s.rollback ());
+        assert (bb.string () == "");
+      }
+    }
+
+    // Invalidated by overflow writing the buffer out.
+    //
+    {
+      stringstream ss;
+      stream_serializer s (ss, 0);
+      s.begin_array ();
+      s.mark ();
+      s.value (string (5000, 'x'));
+      assert (!s.rollback ());
+    }
+  }
+
+  // Numeric arrays.
+  //
+  {
+    // Return the value_array() and the element-wise output.
+    //
+    auto arrays = [] (const auto& v, size_t ind)
+    {
+      pair<string, string> r;
+      {
+        buffer_serializer s (r.first, ind);
+        s.begin_object ();
+        s.member_name ("a");
+        s.value_array (v);
+        s.end_object ();
+      }
+      {
+        buffer_serializer s (r.second, ind);
+        s.begin_object ();
+        s.member_name ("a");
+        s.begin_array ();
+        for (auto x: v)
+          s.value (x);
+        s.end_array ();
+        s.end_object ();
+      }
+      return r;
+    };
+
+    for (size_t ind: {0, 2})
+    {
+      {
+        vector<long long> v {0, 1, -1, 9, 10, -10, 99, 100, 12345,
+                             numeric_limits<long long>::max (),
+                             numeric_limits<long long>::min ()};
+
+        // Enough to span several blocks.
+        //
+        for (long long i (0); i != 2000; ++i)
+          v.push_back (i * 1000003 - 7);
+
+        auto r (arrays (v, ind));
+        assert (r.first == r.second);
+      }
+
+      {
+        vector<unsigned long long> v {
+          0, 7, numeric_limits<unsigned long long>::max ()};
+
+        auto r (arrays (v, ind));
+        assert (r.first == r.second);
+      }
+
+      {
+        vector<double> v {0.0, -1.5, 3.14159265358979, 1e300, -2.5e-300};
+
+        for (int i (0); i != 1000; ++i)
+          v.push_back (i / 7.0);
+
+        auto r (arrays (v, ind));
+        assert (r.first == r.second);
+      }
+
+      {
+        vector<int> v;
+        auto r (arrays (v, ind));
+        assert (r.first == r.second);
+      }
+    }
+
+    {
+      string b;
+      buffer_serializer s (b, 0);
+      int v[] {1, -2, 3};
+      s.value_array (v, 3);
+      assert (b == "[1,-2,3]");
+    }
+  }
+
+#ifdef LIBSTUD_JSON_STATISTICS
+  // Statistics.
+  //
+  {
+    {
+      string b;
+      buffer_serializer s (b, 0);
+      s.begin_array ();
+      s.value ("a\"b\n\x01");
+      s.value ("x", false /* check */);
+      s.value (123);
+      s.end_array ();
+
+      const buffer_serializer::statistics& st (s.stats ());
+      assert (st.bytes == b.size ());
+      assert (st.escapes == 3);
+      assert (st.checked_bytes == 5 + 3);
+      assert (st.flush_calls == 1);
+      assert (st.overflow_calls != 0);
+    }
+
+    {
+      stringstream ss;
+      stream_serializer s (ss, 0);
+      s.value (1);
+      s.value (string (5000, 'x'));
+
+      const buffer_serializer::statistics& st (s.stats ());
+      assert (st.bytes == ss.str ().size ());
+      assert (st.flush_calls == 2);
+      assert (st.overflow_calls != 0);
+    }
+  }
+#endif
+
   // Buffer management.
   //
   {
@@ -306,6 +724,102 @@ main ()
       }
     }
 
+    // Block buffer.
+    //
+    {
+      block_buffer bb (16);
+
+      const string v (20, 'a');
+      {
+        buffer_serializer s (bb, 0);
+        s.begin_array ();
+        s.value (v);
+        s.value (123);
+        s.end_array ();
+      }
+
+      const string r ("[\"" + v + "\",123]");
+      assert (bb.string () == r);
+      assert (bb.size () == r.size ());
+      assert (bb.blocks ().size () > 1);
+
+      // Append.
+      //
+      {
+        buffer_serializer s (bb, 0);
+        s.value (true);
+      }
+
+      assert (bb.string () == r + "true");
+
+      // Blocks are recycled.
+      //
+      const char* p (bb.blocks ().front ().data);
+      size_t n (bb.blocks ().size ());
+
+      bb.clear ();
+      assert (bb.size () == 0);
+      {
+        buffer_serializer s (bb, 0);
+        s.begin_array ();
+        s.value (v);
+        s.value (123);
+        s.end_array ();
+      }
+
+      assert (bb.string () == r);
+      assert (bb.blocks ().size () <= n);
+
+      bool f (false);
+      for (const block_buffer::block& b: bb.blocks ())
+        f = f || b.data == p;
+      assert (f);
+    }
+
+    // Block buffer with writes (indentation, multi-value separator) that
+    // are longer than the block size.
+    //
+    {
+      const string sep (40, ' ');
+
+      auto write = [&sep] (buffer_serializer& s)
+      {
+        for (size_t i (0); i != 10; ++i)
+          s.begin_array ();
+
+        s.value (1);
+
+        for (size_t i (0); i != 10; ++i)
+          s.end_array ();
+
+        s.value (2);
+      };
+
+      string r;
+      {
+        buffer_serializer s (r, 2, sep.c_str ());
+        write (s);
+      }
+
+      block_buffer bb (16);
+      {
+        buffer_serializer s (bb, 2, sep.c_str ());
+        write (s);
+      }
+
+      assert (bb.string () == r);
+
+      // Recycled blocks that are too small are not reused for such writes.
+      //
+      bb.clear ();
+      {
+        buffer_serializer s (bb, 2, sep.c_str ());
+        write (s);
+      }
+
+      assert (bb.string () == r);
+    }
+
     // Regression tests.
     //
     {
@@ -556,5 +1070,507 @@ main ()
       s.end_array ();
       assert (b == "[{\"a\":1},{\"a\":2}]");
     }
+
+    // Incremental string and member name.
+    //
+    {
+      string b;
+      buffer_serializer s (b, 2);
+      s.begin_object ();
+      s.begin_member_name ();
+      s.append_string ("a\"");
+      s.append_string ("b");
+      s.end_string ();
+      s.begin_string ();
+      s.end_string ();
+      s.member_name ("c");
+      s.begin_array ();
+      s.begin_string ();
+      s.append_string ("x\n", 2);
+      s.append_string ("", 0);
+      s.append_string ("y", 1);
+      s.end_string ();
+      s.value (1);
+      s.end_array ();
+      s.end_object ();
+
+      string r;
+      buffer_serializer rs (r, 2);
+      rs.begin_object ();
+      rs.member ("a\"b", "");
+      rs.member_name ("c");
+      rs.begin_array ();
+      rs.value ("x\ny");
+      rs.value (1);
+      rs.end_array ();
+      rs.end_object ();
+
+      assert (b == r);
+    }
+
+    // Incremental string with UTF-8 sequences split between chunks in all
+    // possible ways.
+    //
+    {
+      const string v ("a\xC2\xA2\xE2\x82\xAC\xF0\x9F\x98\x80z");
+
+      for (size_t n (1); n <= v.size (); ++n)
+      {
+        string b;
+        buffer_serializer s (b);
+        s.begin_string ();
+        for (size_t i (0); i < v.size (); i += n)
+          s.append_string (v.c_str () + i, min (n, v.size () - i));
+        s.end_string ();
+        assert (b == '"' + v + '"');
+      }
+    }
+
+    // Incremental string with invalid UTF-8.
+    //
+    {
+      auto throws = [] (const vector<string>& cs, bool check = true)
+      {
+        string b;
+        buffer_serializer s (b);
+        try
+        {
+          s.begin_string (check);
+          for (const string& c: cs)
+            s.append_string (c);
+          s.end_string ();
+          return false;
+        }
+        catch (const invalid_json_output& e)
+        {
+          return e.code == error::invalid_value;
+        }
+      };
+
+      assert (throws ({"a\xE2\x82"}));              // Truncated at the end.
+      assert (throws ({"a\xE2", "b\xAC"}));         // Interrupted.
+      assert (throws ({"a\xE2", "\x82", "\xFF"}));  // Invalid continuation.
+      assert (throws ({"\xC0\xB0"}));               // Overlong.
+      assert (!throws ({"\xC0\xB0"}, false));       // Unchecked.
+      assert (!throws ({"\xE2", "\x82", "\xAC"}));
+    }
+
+    // Incremental string: unexpected events.
+    //
+    {
+      string b;
+      buffer_serializer s (b, 0);
+      s.begin_array ();
+      s.begin_string ();
+      assert (next_throws (error::unexpected_event, s, event::end_array));
+      assert (next_throws (error::invalid_value, s, nullopt));
+      s.end_string ();
+      s.end_array ();
+      assert (b == "[\"\"]");
+
+      try
+      {
+        s.end_string ();
+        assert (false);
+      }
+      catch (const invalid_json_output& e)
+      {
+        assert (e.code == error::unexpected_event);
+      }
+    }
+    {
+      string b;
+      buffer_serializer s (b);
+      s.begin_object ();
+      try
+      {
+        s.begin_string ();
+        assert (false);
+      }
+      catch (const invalid_json_output& e)
+      {
+        assert (e.code == error::unexpected_event);
+      }
+    }
+
+  }
+
+  // Non-blocking serializer.
+  //
+  {
+    // Sink that accepts up to the specified number of bytes until it is
+    // made writable again.
+    //
+    struct sink
+    {
+      string text;
+      size_t quota;
+    };
+
+    auto write = [] (void* d, const char* p, size_t n) -> size_t
+    {
+      sink& k (*static_cast<sink*> (d));
+      if (n > k.quota)
+        n = k.quota;
+      k.text.append (p, n);
+      k.quota -= n;
+      return n;
+    };
+
+    // Output is kept (and the buffer grows) while the sink would block.
+    //
+    {
+      sink k {"", 0};
+      nonblocking_serializer s (write, &k, 0, "\n", 16);
+
+      const string v (100, 'a');
+
+      s.begin_array ();
+      for (size_t i (0); i != 10; ++i)
+        s.value (v);
+      s.end_array ();
+
+      const string r ("[\"" + v + "\",\"" + v + "\",\"" + v + "\",\"" + v +
+                      "\",\"" + v + "\",\"" + v + "\",\"" + v + "\",\"" + v +
+                      "\",\"" + v + "\",\"" + v + "\"]");
+
+      assert (k.text.empty () && s.pending () == r.size ());
+
+      k.quota = 100;
+      assert (!s.flush ());
+      assert (k.text == r.substr (0, 100));
+      assert (s.pending () == r.size () - 100);
+
+      k.quota = r.size ();
+      assert (s.flush ());
+      assert (k.text == r && s.pending () == 0);
+    }
+
+    // Producer that stops when the pending output exceeds its limit and
+    // resumes when the sink becomes writable.
+    //
+    {
+      sink k {"", 0};
+      nonblocking_serializer s (write, &k, 0, "\n", 64);
+
+      string r;
+      {
+        buffer_serializer rs (r, 0);
+        rs.begin_array ();
+        for (size_t i (0); i != 1000; ++i)
+          rs.value (i);
+        rs.end_array ();
+      }
+
+      size_t max (0);
+
+      s.begin_array ();
+      for (size_t i (0); i != 1000; ++i)
+      {
+        s.value (i);
+
+        if (s.pending () > max)
+          max = s.pending ();
+
+        if (s.pending () >= 32)
+        {
+          do
+            k.quota = 7;
+          while (!s.flush ());
+        }
+      }
+      s.end_array ();
+
+      k.quota = s.pending ();
+      assert (s.flush ());
+
+      assert (k.text == r);
+      assert (max < 64);
+    }
+
+    // Rollback is not possible once the marked output has been written.
+    //
+    {
+      sink k {"", 0};
+      nonblocking_serializer s (write, &k, 0);
+
+      s.begin_array ();
+      s.value (1);
+      s.mark ();
+      s.value (2);
+      assert (s.rollback ());
+      s.value (3);
+
+      k.quota = 100;
+      assert (s.flush ());
+      assert (k.text == "[1,3");
+
+      assert (!s.rollback ());
+    }
+
+    // Producer that relies on the high-water mark: the unit of output that
+    // does not fit is rolled back and serialized again once the sink
+    // becomes writable.
+    //
+    {
+      sink k {"", 0};
+      nonblocking_serializer s (write, &k, 0, "\n", 16, 64);
+
+      string r;
+      {
+        buffer_serializer rs (r, 0);
+        rs.begin_array ();
+        for (size_t i (0); i != 100; ++i)
+          rs.value ("value " + to_string (i));
+        rs.end_array ();
+      }
+
+      size_t n (0); // Number of times the limit has been reached.
+
+      s.begin_array ();
+      for (size_t i (0); i != 100; )
+      {
+        s.mark ();
+
+        try
+        {
+          s.value ("value " + to_string (i));
+          ++i;
+        }
+        catch (const invalid_json_output& e)
+        {
+          assert (e.event && *e.event == event::string);
+          assert (e.code == invalid_json_output::error_code::buffer_overflow);
+          assert (s.pending () <= 64);
+          assert (s.rollback ());
+
+          ++n;
+          k.quota = 10;
+          while (!s.flush ())
+            k.quota = 10;
+          k.quota = 0;
+        }
+      }
+      s.end_array ();
+
+      k.quota = s.pending ();
+      assert (s.flush ());
+
+      assert (k.text == r);
+      assert (n != 0);
+    }
+
+    // A value larger than the high-water mark can still be written if the
+    // sink does not block.
+    //
+    {
+      sink k {"", 1000};
+      nonblocking_serializer s (write, &k, 0, "\n", 16, 32);
+
+      const string v (500, 'a');
+      s.value (v);
+      assert (s.pending () == 0 && k.text == '"' + v + '"');
+    }
+  }
+
+#ifndef _WIN32
+  // File descriptor serializer.
+  //
+  {
+    // Return the contents of the file.
+    //
+    auto read = [] (FILE* f)
+    {
+      string r;
+      rewind (f);
+      for (int c; (c = fgetc (f)) != EOF; )
+        r += static_cast<char> (c);
+      return r;
+    };
+
+    // Large string values written directly (gathered) interleaved with
+    // buffered output text, escapes, and chunks that are too short.
+    //
+    {
+      FILE* f (tmpfile ());
+      assert (f != nullptr);
+
+      const string v (10000, 'a');
+      {
+        fd_serializer s (fileno (f), 0, "\n", 4096, 0, 100 /* gather */);
+        s.begin_array ();
+        s.value ("abc");
+        s.value (v);
+        s.value (v + '"' + v + "\x01\xE2\x82\xAC" + string (10, 'b'));
+        s.value (v, false /* check */);
+        s.end_array ();
+      }
+
+      assert (read (f) == "[\"abc\",\"" + v + "\",\"" +
+                          v + "\\\"" + v + "\\u0001\xE2\x82\xAC" +
+                          string (10, 'b') + "\",\"" + v + "\"]");
+      fclose (f);
+    }
+
+    // Invalid UTF-8 in a gathered chunk.
+    //
+    {
+      FILE* f (tmpfile ());
+      assert (f != nullptr);
+      {
+        fd_serializer s (fileno (f), 0, "\n", 4096, 0, 100 /* gather */);
+
+        try
+        {
+          s.value (string (200, 'a') + "\xC2");
+          assert (false);
+        }
+        catch (const invalid_json_output& e)
+        {
+          assert (e.code == error::invalid_value && e.offset == 200);
+        }
+      }
+      fclose (f);
+    }
+
+    // Complete values are buffered unless flush_values is true and the
+    // rest is written on destruction.
+    //
+    {
+      FILE* f (tmpfile ());
+      assert (f != nullptr);
+      {
+        fd_serializer s (fileno (f), 0, "\n", 4096);
+        s.value (1);
+        s.value (2);
+        assert (read (f) == "");
+
+        s.flush ();
+        assert (read (f) == "1\n2");
+
+        s.flush_values = true;
+        s.value (3);
+        assert (read (f) == "1\n2\n3");
+
+        s.flush_values = false;
+        s.value (4);
+        assert (read (f) == "1\n2\n3");
+      }
+      assert (read (f) == "1\n2\n3\n4");
+
+      fclose (f);
+    }
+
+    // Aligned buffer: only whole blocks are written until flush().
+    //
+    {
+      FILE* f (tmpfile ());
+      assert (f != nullptr);
+
+      fd_serializer s (fileno (f), 0, "\n", 20, 8);
+      s.begin_array ();
+      for (size_t i (0); i != 10; ++i)
+        s.value ("abc");
+      s.end_array ();
+      s.value (123);
+
+      const string r ("[\"abc\",\"abc\",\"abc\",\"abc\",\"abc\","
+                      "\"abc\",\"abc\",\"abc\",\"abc\",\"abc\"]\n123");
+
+      string b (read (f));
+      assert (b.size () % 8 == 0 && r.compare (0, b.size (), b) == 0);
+
+      s.flush (true /* sync */);
+      assert (read (f) == r);
+
+      fclose (f);
+    }
+
+    // Aligned buffer of the minimum size (two blocks).
+    //
+    {
+      try
+      {
+        fd_serializer s (1, 0, "\n", 4096, 4096);
+        assert (false);
+      }
+      catch (const invalid_argument&) {}
+
+      FILE* f (tmpfile ());
+      assert (f != nullptr);
+
+      string r;
+      {
+        fd_serializer s (fileno (f), 2, "\n", 16, 8);
+
+        for (size_t i (0); i != 10; ++i)
+        {
+          s.begin_array ();
+          s.value ("abcdef");
+          s.end_array ();
+
+          if (i != 0)
+            r += '\n';
+
+          r += "[\n  \"abcdef\"\n]";
+        }
+
+        s.flush ();
+      }
+
+      assert (read (f) == r);
+      fclose (f);
+    }
+
+    // Non-blocking serializer writing to a pipe that fills up.
+    //
+    {
+      int fd[2];
+      assert (pipe (fd) == 0);
+      assert (fcntl (fd[0], F_SETFL, O_NONBLOCK) == 0);
+      assert (fcntl (fd[1], F_SETFL, O_NONBLOCK) == 0);
+
+      // Read everything that is currently in the pipe.
+      //
+      string t;
+      auto drain = [&fd, &t] ()
+      {
+        char b[4096];
+        for (ssize_t n; (n = ::read (fd[0], b, sizeof (b))) > 0; )
+          t.append (b, static_cast<size_t> (n));
+      };
+
+      string r;
+      {
+        nonblocking_serializer s (fd[1], 0);
+
+        const string v (1000000, 'a'); // Larger than any pipe buffer.
+        s.begin_array ();
+        for (size_t i (0); i != 3; ++i)
+        {
+          s.value (v);
+
+          r += i == 0 ? "[\"" : ",\"";
+          r += v;
+          r += '"';
+        }
+        s.end_array ();
+        r += ']';
+
+        assert (s.pending () != 0); // Would block.
+
+        while (!s.flush ())
+          drain ();
+
+        assert (s.pending () == 0);
+      }
+
+      drain ();
+      assert (t == r);
+
+      close (fd[0]);
+      close (fd[1]);
+    }
   }
+#endif
 }
@@ -0,0 +1,225 @@
+#include <string>
+#include <sstream>
+#include <cstddef> // size_t
+
+#include <libstud/json/serializer.hxx>
+
+#ifdef LIBSTUD_JSON_TEST_ZLIB
+#  include <zlib.h>
+#  include <libstud/json/zlib-serializer.hxx>
+#endif
+
+#ifdef LIBSTUD_JSON_TEST_ZSTD
+#  include <zstd.h>
+#  include <libstud/json/zstd-serializer.hxx>
+#endif
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Serialize the n-th value.
+//
+static void
+serialize (buffer_serializer& s, size_t i)
+{
+  s.begin_object ();
+  s.member ("id", i);
+  s.member ("name", "value " + to_string (i * 7919 % 10007));
+  s.member_begin_array ("tags");
+  for (size_t j (0); j != i % 5; ++j)
+    s.value (j % 2 == 0);
+  s.end_array ();
+  s.end_object ();
+}
+
+// Serialize the first n values uncompressed.
+//
+static string
+expected (size_t n, size_t indentation)
+{
+  string r;
+  {
+    buffer_serializer s (r, indentation);
+    for (size_t i (0); i != n; ++i)
+      serialize (s, i);
+  }
+  return r;
+}
+
+#ifdef LIBSTUD_JSON_TEST_ZLIB
+// Decompress as much of the zlib/gzip data as possible setting complete to
+// true if the end of the compressed stream is reached.
+//
+static string
+inflate (const string& d, bool gzip, bool& complete)
+{
+  z_stream zs {};
+  assert (inflateInit2 (&zs, gzip ? 15 + 16 : 15) == Z_OK);
+
+  zs.next_in = reinterpret_cast<Bytef*> (const_cast<char*> (d.data ()));
+  zs.avail_in = static_cast<uInt> (d.size ());
+
+  string r;
+  int e;
+  do
+  {
+    char b[4096];
+    zs.next_out = reinterpret_cast<Bytef*> (b);
+    zs.avail_out = sizeof (b);
+
+    e = ::inflate (&zs, Z_SYNC_FLUSH);
+    assert (e == Z_OK || e == Z_STREAM_END || e == Z_BUF_ERROR);
+
+    r.append (b, sizeof (b) - zs.avail_out);
+  }
+  while (e == Z_OK);
+
+  complete = (e == Z_STREAM_END);
+  inflateEnd (&zs);
+  return r;
+}
+#endif
+
+#ifdef LIBSTUD_JSON_TEST_ZSTD
+// As above but for zstd.
+//
+static string
+decompress (const string& d, bool& complete)
+{
+  ZSTD_DStream* ds (ZSTD_createDStream ());
+  assert (ds != nullptr);
+
+  ZSTD_inBuffer in {d.data (), d.size (), 0};
+
+  string r;
+  size_t e (1);
+  for (;;)
+  {
+    char b[4096];
+    ZSTD_outBuffer out {b, sizeof (b), 0};
+
+    e = ZSTD_decompressStream (ds, &out, &in);
+    assert (!ZSTD_isError (e));
+
+    r.append (b, out.pos);
+
+    if (e == 0 || (in.pos == in.size && out.pos != sizeof (b)))
+      break;
+  }
+
+  complete = (e == 0);
+  ZSTD_freeDStream (ds);
+  return r;
+}
+#endif
+
+int
+main ()
+{
+#if defined(LIBSTUD_JSON_TEST_ZLIB) || defined(LIBSTUD_JSON_TEST_ZSTD)
+  // Enough values to fill the input and output buffers several times.
+  //
+  const size_t n (20000);
+  const string v (expected (n, 2));
+
+  // Values that are small enough not to fill the input buffer.
+  //
+  const size_t m (5);
+
+  bool c;
+#endif
+
+#ifdef LIBSTUD_JSON_TEST_ZLIB
+  for (bool gz: {true, false})
+  {
+    // Round trip.
+    //
+    {
+      ostringstream os;
+      {
+        zlib_serializer s (os, 2, "\n", Z_DEFAULT_COMPRESSION, gz);
+        for (size_t i (0); i != n; ++i)
+          serialize (s, i);
+        s.finish ();
+      }
+
+      assert (inflate (os.str (), gz, c) == v && c);
+    }
+
+    // No values.
+    //
+    {
+      ostringstream os;
+      {
+        zlib_serializer s (os, 0, "\n", 1, gz);
+        s.finish ();
+      }
+
+      assert (inflate (os.str (), gz, c) == "" && c);
+    }
+
+    // Each value can be decompressed once serialized with sync_flush.
+    //
+    {
+      ostringstream os;
+      zlib_serializer s (os, 0, "\n", 9, gz, true /* sync_flush */);
+      for (size_t i (0); i != m; ++i)
+      {
+        serialize (s, i);
+        assert (inflate (os.str (), gz, c) == expected (i + 1, 0) && !c);
+      }
+      s.finish ();
+
+      assert (inflate (os.str (), gz, c) == expected (m, 0) && c);
+    }
+  }
+#endif
+
+#ifdef LIBSTUD_JSON_TEST_ZSTD
+  {
+    // Round trip.
+    //
+    {
+      ostringstream os;
+      {
+        zstd_serializer s (os, 2, "\n");
+        for (size_t i (0); i != n; ++i)
+          serialize (s, i);
+        s.finish ();
+      }
+
+      assert (decompress (os.str (), c) == v && c);
+    }
+
+    // No values.
+    //
+    {
+      ostringstream os;
+      {
+        zstd_serializer s (os, 0, "\n", 1);
+        s.finish ();
+      }
+
+      assert (decompress (os.str (), c) == "" && c);
+    }
+
+    // Each value can be decompressed once serialized with sync_flush.
+    //
+    {
+      ostringstream os;
+      zstd_serializer s (os, 0, "\n", 19, true /* sync_flush */);
+      for (size_t i (0); i != m; ++i)
+      {
+        serialize (s, i);
+        assert (decompress (os.str (), c) == expected (i + 1, 0) && !c);
+      }
+      s.finish ();
+
+      assert (decompress (os.str (), c) == expected (m, 0) && c);
+    }
+  }
+#endif
+}
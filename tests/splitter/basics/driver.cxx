@@ -0,0 +1,131 @@
+#include <string>
+#include <vector>
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/splitter.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Split the input feeding it in chunks of the specified size. Return the
+// values each followed by its line, column, and position.
+//
+static vector<string>
+split (const string& s,
+       size_t chunk,
+       const char* sep = nullptr,
+       size_t max = 0)
+{
+  vector<string> r;
+  value_splitter sp ("test", sep, max);
+
+  for (size_t i (0);; )
+  {
+    pair<const char*, size_t> v;
+    if (sp.next (v))
+    {
+      r.push_back (string (v.first, v.second));
+      r.push_back (to_string (sp.line ()) + ':' +
+                   to_string (sp.column ()) + ':' +
+                   to_string (sp.position ()));
+      continue;
+    }
+
+    if (sp.finished ())
+      break;
+
+    if (i != s.size ())
+    {
+      size_t n (min (chunk, s.size () - i));
+      sp.feed (s.data () + i, n);
+      i += n;
+    }
+    else
+      sp.finish ();
+  }
+
+  return r;
+}
+
+int
+main ()
+{
+  const string s ("{\"a\": [1, \"]}\\\"\", {}], \"b\": null}\n"
+                  "  [1,\n2]\n"
+                  "\"x\\\\\" 123 -1.5e+3\n"
+                  "true false null\n"
+                  "[]{}\"\"");
+
+  const vector<string> r {
+    "{\"a\": [1, \"]}\\\"\", {}], \"b\": null}", "1:1:0",
+    "[1,\n2]",                                  "2:3:36",
+    "\"x\\\\\"",                                "4:1:43",
+    "123",                                      "4:7:49",
+    "-1.5e+3",                                  "4:11:53",
+    "true",                                     "5:1:61",
+    "false",                                    "5:6:66",
+    "null",                                     "5:12:72",
+    "[]",                                       "6:1:77",
+    "{}",                                       "6:3:79",
+    "\"\"",                                     "6:5:81"};
+
+  for (size_t c (1); c <= s.size (); ++c)
+    assert (split (s, c) == r);
+
+  // Every value parses.
+  //
+  for (size_t i (0); i < r.size (); i += 2)
+  {
+    parser p (r[i], "test");
+    while (p.next ()) ;
+  }
+
+  // Columns are counted in code points.
+  //
+  {
+    const string s ("\"\xD1\x84\xE0\xA4\xB9\" [\"\xF0\x9F\x98\x80\"] 1\n"
+                    "\"\xC2\xA0\" 2");
+
+    for (size_t c (1); c <= s.size (); ++c)
+      assert ((split (s, c) ==
+               vector<string> {"\"\xD1\x84\xE0\xA4\xB9\"", "1:1:0",
+                               "[\"\xF0\x9F\x98\x80\"]",    "1:6:8",
+                               "1",                        "1:12:17",
+                               "\"\xC2\xA0\"",             "2:1:19",
+                               "2",                        "2:5:24"}));
+  }
+
+  // Separators.
+  //
+  assert ((split ("1\x1E" "2\x1E" "\x1E[3]", 2, "\x1E") ==
+           vector<string> {"1", "1:1:0", "2", "1:3:2", "[3]", "1:6:5"}));
+
+  // Empty input and incomplete value at the end of input.
+  //
+  assert (split ("", 1).empty ());
+  assert (split (" \n ", 1).empty ());
+  assert ((split ("1 {\"a\": [", 3) ==
+           vector<string> {"1", "1:1:0", "{\"a\": [", "1:3:2"}));
+  assert ((split ("\"abc", 3) == vector<string> {"\"abc", "1:1:0"}));
+
+  // Size limit.
+  //
+  {
+    assert (split ("[1, 2] [3]", 2, nullptr, 6).size () == 4);
+
+    try
+    {
+      split ("[1] [1, 2, 3] [4]", 2, nullptr, 6);
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (e.name == "test");
+      assert (e.position == 4);
+    }
+  }
+}
@@ -0,0 +1,303 @@
+#include <string>
+#include <stdexcept> // invalid_argument
+
+#include <libstud/optional.hxx>
+#include <libstud/json/parser.hxx>
+#include <libstud/json/validator.hxx>
+
+#undef NDEBUG
+#include <cassert>
+
+using namespace std;
+using namespace stud::json;
+
+// Validate the input against the schema. Return the empty string if the
+// input is valid and the error description otherwise.
+//
+static string
+validate (const string& sc, const string& in)
+{
+  schema s (sc);
+  parser p (in, "test");
+  validator v (s);
+
+  try
+  {
+    while (stud::optional<event> e = p.next ())
+      v.next (p, *e);
+
+    assert (v.complete ());
+    return "";
+  }
+  catch (const invalid_json_input& e)
+  {
+    return e.what ();
+  }
+}
+
+// Return the error description if the schema is invalid and the empty
+// string otherwise.
+//
+static string
+compile (const string& sc)
+{
+  try
+  {
+    schema s (sc);
+    return "";
+  }
+  catch (const invalid_json_input& e)
+  {
+    return e.what ();
+  }
+}
+
+int
+main ()
+{
+  // Boolean schemas.
+  //
+  assert (validate ("true", "[1,{\"a\":null}]") == "");
+  assert (validate ("false", "1") == "unexpected number value");
+  assert (validate ("{}", "\"abc\"") == "");
+
+  // Types.
+  //
+  {
+    const string s ("{\"type\":\"string\"}");
+    assert (validate (s, "\"abc\"") == "");
+    assert (validate (s, "123") == "expected string instead of number");
+    assert (validate (s, "{}") == "expected string instead of object");
+
+    const string n ("{\"type\":[\"string\",\"null\"]}");
+    assert (validate (n, "null") == "");
+    assert (validate (n, "true") ==
+            "expected null or string instead of boolean");
+
+    const string i ("{\"type\":\"integer\"}");
+    assert (validate (i, "123") == "");
+    assert (validate (i, "-1.0") == "");
+    assert (validate (i, "1e2") == "");
+    assert (validate (i, "1.5") == "expected integer instead of number");
+
+    const string m ("{\"type\":\"number\"}");
+    assert (validate (m, "1.5") == "");
+    assert (validate (m, "7") == "");
+  }
+
+  // Enum and const.
+  //
+  {
+    const string s ("{\"enum\":[\"red\",\"green\",1,true,null]}");
+    assert (validate (s, "\"green\"") == "");
+    assert (validate (s, "1.0") == "");
+    assert (validate (s, "true") == "");
+    assert (validate (s, "null") == "");
+    assert (validate (s, "\"blue\"") ==
+            "string value is not one of the enumerated values");
+    assert (validate (s, "false") ==
+            "boolean value is not one of the enumerated values");
+    assert (validate (s, "[]") ==
+            "array value is not one of the enumerated values");
+
+    assert (validate ("{\"const\":\"x\"}", "\"x\"") == "");
+    assert (validate ("{\"const\":\"x\"}", "\"y\"") ==
+            "string value is not one of the enumerated values");
+  }
+
+  // Numbers.
+  //
+  {
+    const string s ("{\"minimum\":1,\"exclusiveMaximum\":10}");
+    assert (validate (s, "1") == "");
+    assert (validate (s, "9.5") == "");
+    assert (validate (s, "0.5") == "number 0.5 is less than minimum");
+    assert (validate (s, "10") ==
+            "number 10 is greater than or equal to maximum");
+    assert (validate (s, "\"x\"") == ""); // Only applies to numbers.
+
+    // Both inclusive and exclusive bounds apply, in either order.
+    //
+    for (const char* s: {"{\"exclusiveMinimum\":5,\"minimum\":0}",
+                         "{\"minimum\":0,\"exclusiveMinimum\":5}"})
+    {
+      assert (validate (s, "6") == "");
+      assert (validate (s, "3") ==
+              "number 3 is less than or equal to minimum");
+      assert (validate (s, "5") ==
+              "number 5 is less than or equal to minimum");
+    }
+
+    for (const char* s: {"{\"maximum\":10,\"exclusiveMaximum\":100}",
+                         "{\"exclusiveMaximum\":100,\"maximum\":10}"})
+    {
+      assert (validate (s, "10") == "");
+      assert (validate (s, "50") == "number 50 is greater than maximum");
+    }
+
+    for (const char* s: {"{\"minimum\":5,\"exclusiveMinimum\":0}",
+                         "{\"exclusiveMinimum\":0,\"minimum\":5}"})
+    {
+      assert (validate (s, "5") == "");
+      assert (validate (s, "3") == "number 3 is less than minimum");
+    }
+  }
+
+  // Strings.
+  //
+  {
+    const string s ("{\"minLength\":2,\"maxLength\":3}");
+    assert (validate (s, "\"ab\"") == "");
+    assert (validate (s, "\"\xE2\x82\xAC\xE2\x82\xAC\xE2\x82\xAC\"") == "");
+    assert (validate (s, "\"a\"") ==
+            "string is shorter than 2 characters");
+    assert (validate (s, "\"abcd\"") ==
+            "string is longer than 3 characters");
+  }
+
+  // Arrays.
+  //
+  {
+    const string s ("{\"type\":\"array\",\"items\":{\"type\":\"integer\"},"
+                    "\"minItems\":1,\"maxItems\":3}");
+    assert (validate (s, "[1,2,3]") == "");
+    assert (validate (s, "[1,\"2\"]") ==
+            "expected integer instead of string");
+    assert (validate (s, "[]") == "array has fewer than 1 elements");
+    assert (validate (s, "[1,2,3,4]") ==
+            "array has more than 3 elements");
+
+    // Nested arrays with unconstrained elements.
+    //
+    assert (validate ("{\"maxItems\":1}", "[[1,[2,3]]]") == "");
+  }
+
+  // Objects.
+  //
+  {
+    const string s (
+      "{"
+      "  \"type\": \"object\","
+      "  \"properties\": {"
+      "    \"name\": {\"type\": \"string\", \"maxLength\": 5},"
+      "    \"tags\": {\"type\": \"array\", \"items\": {\"type\": \"string\"}},"
+      "    \"size\": {\"type\": \"object\","
+      "               \"properties\": {\"w\": {\"type\": \"integer\"}},"
+      "               \"required\": [\"w\", \"h\"]}"
+      "  },"
+      "  \"required\": [\"name\"],"
+      "  \"additionalProperties\": false"
+      "}");
+
+    assert (validate (s, "{\"name\":\"abc\"}") == "");
+    assert (validate (s,
+                      "{\"tags\":[\"a\",\"b\"],"
+                      "\"size\":{\"h\":{\"x\":[1]},\"w\":1},"
+                      "\"name\":\"abc\"}") == "");
+
+    assert (validate (s, "{}") ==
+            "missing required object member 'name'");
+    assert (validate (s, "{\"name\":\"abc\",\"size\":{\"w\":1}}") ==
+            "missing required object member 'h'");
+    assert (validate (s, "{\"name\":\"abcdef\"}") ==
+            "string is longer than 5 characters");
+    assert (validate (s, "{\"name\":\"abc\",\"tags\":[1]}") ==
+            "expected string instead of number");
+    assert (validate (s, "{\"name\":\"abc\",\"extra\":1}") ==
+            "unexpected object member 'extra'");
+    assert (validate (s, "[]") == "expected object instead of array");
+
+    // Additional members schema and member count.
+    //
+    const string a ("{\"additionalProperties\":{\"type\":\"number\"},"
+                    "\"maxProperties\":2}");
+    assert (validate (a, "{\"a\":1,\"b\":2}") == "");
+    assert (validate (a, "{\"a\":\"1\"}") ==
+            "expected number instead of string");
+    assert (validate (a, "{\"a\":1,\"b\":2,\"c\":3}") ==
+            "object has more than 2 members");
+
+    // Values of required members not listed in properties are subject to
+    // additionalProperties.
+    //
+    for (const char* s: {
+           "{\"required\":[\"x\"],\"additionalProperties\":false}",
+           "{\"additionalProperties\":false,\"required\":[\"x\"]}"})
+    {
+      assert (validate (s, "{\"x\":1}") == "unexpected object member 'x'");
+      assert (validate (s, "{}") == "missing required object member 'x'");
+    }
+
+    const string r ("{\"required\":[\"x\"],"
+                    "\"additionalProperties\":{\"type\":\"string\"}}");
+    assert (validate (r, "{\"x\":\"1\"}") == "");
+    assert (validate (r, "{\"x\":1}") == "expected string instead of number");
+  }
+
+  // Error location is that of the offending event.
+  //
+  {
+    schema s ("{\"items\":{\"type\":\"object\",\"required\":[\"a\"]},"
+              "\"maxItems\":2}");
+
+    auto location = [&s] (const string& in)
+    {
+      parser p (in, "test");
+      validator v (s);
+
+      try
+      {
+        v.validate (p);
+        assert (false);
+      }
+      catch (const invalid_json_input& e)
+      {
+        assert (e.name == "test");
+        return to_string (e.line) + ':' + to_string (e.column);
+      }
+
+      return string ();
+    };
+
+    assert (location ("[{\"a\":1},\n 1]") == "2:2");
+    assert (location ("[{\"a\":1},\n {\"b\":1}]") == "2:8");
+    assert (location ("[{\"a\":1},{\"a\":2},\n\n  {}]") == "3:3");
+  }
+
+  // Multiple values.
+  //
+  {
+    schema s ("{\"type\":\"object\",\"required\":[\"id\"]}");
+    parser p ("{\"id\":1} {\"id\":2}\n{\"id\":3}", "test", true);
+    validator v (s);
+    assert (v.validate (p) == 3);
+
+    parser q ("{\"id\":1} {\"x\":2}", "test", true);
+    validator w (s);
+    try
+    {
+      w.validate (q);
+      assert (false);
+    }
+    catch (const invalid_json_input& e)
+    {
+      assert (e.name == "test" && e.line == 1 && e.column == 16);
+    }
+  }
+
+  // Invalid and unsupported schemas.
+  //
+  assert (compile ("{\"type\":\"integer\",\"title\":\"x\",\"default\":[1]}") ==
+          "");
+  assert (compile ("1") == "invalid schema: object or boolean expected");
+  assert (compile ("{\"type\":\"text\"}") ==
+          "invalid schema: unknown type 'text'");
+  assert (compile ("{\"pattern\":\"^a\"}") ==
+          "invalid schema: unsupported keyword 'pattern'");
+  assert (compile ("{\"enum\":[[1]]}") ==
+          "invalid schema: only scalar enum values are supported");
+  assert (compile ("{\"items\":[{}]}") ==
+          "invalid schema: only single schema items are supported");
+  assert (compile ("{\"properties\":{\"a\":{},\"a\":{}}}") ==
+          "invalid schema: duplicate property 'a'");
+}